@@ -0,0 +1,139 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+// Benchmark of APU output stages, as host samples produced per
+// millisecond, with all 4 channels playing.
+
+#include <iostream>
+#include <chrono>
+#include <string.h>
+
+#include "../src/ram.h"
+#include "../src/scheduler.h"
+#include "../src/timing.h"
+#include "../src/apu.h"
+#include "../src/point_sampler.h"
+#include "../src/blep_synth.h"
+
+// Emulated cycles per run (~1 second)
+#define BENCH_CYCLES ((uint64_t)CPU_CLOCK_HZ)
+#define BENCH_RUNS 5
+
+// Square, wave and noise channels playing, with both
+// low and high frequencies
+void start_channels(RAM *ram)
+{
+    const uint16_t registers[][2] = {
+        {0xff26, 0x80}, {0xff24, 0x77}, {0xff25, 0xff},
+        // 440Hz square, 50% duty
+        {0xff11, 0x80}, {0xff12, 0xf0}, {0xff13, 0xd6}, {0xff14, 0x86},
+        // 2.7kHz square, 12.5% duty
+        {0xff16, 0x00}, {0xff17, 0xa0}, {0xff18, 0xd0}, {0xff19, 0x87},
+        // 220Hz wave
+        {0xff1a, 0x80}, {0xff1c, 0x20}, {0xff1d, 0xd6}, {0xff1e, 0x86},
+        // Noise
+        {0xff21, 0x80}, {0xff22, 0x21}, {0xff23, 0x80}
+    };
+    for (unsigned int itx = 0; itx < 16; itx ++)
+        ram->set(0xff30 + itx, (uint8_t)(itx * 0x11));
+    for (auto &reg : registers)
+        ram->set(reg[0], (uint8_t)reg[1]);
+}
+
+// Run APU for BENCH_CYCLES, returning number of samples produced
+uint64_t run_output(RingOutput *output, AudioRing *ring)
+{
+    RAM ram;
+    Scheduler scheduler;
+    Apu apu(&ram, &scheduler);
+    apu.set_output(output);
+    start_channels(&ram);
+
+    uint64_t samples = 0;
+    audio_frame_t frame;
+    while (scheduler.get_cycle() < BENCH_CYCLES)
+    {
+        scheduler.advance(scheduler.get_next_event_cycle() - scheduler.get_cycle());
+        SchedulerEvent event;
+        while (scheduler.pop_due_event(event))
+            if (event == SchedulerEvent::EVENT_APU)
+                apu.frame_sequencer_event();
+        while (ring->pop(frame))
+            samples ++;
+    }
+    return samples;
+}
+
+template <typename T>
+double bench_output(const char *name, unsigned int sample_rate)
+{
+    double best = 0;
+    uint64_t samples = 0;
+    uint64_t dropped = 0;
+    for (unsigned int run_itx = 0; run_itx < BENCH_RUNS; run_itx ++)
+    {
+        AudioRing ring;
+        T output(&ring, sample_rate);
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        samples = run_output(&output, &ring);
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        dropped = output.get_dropped_frames();
+        if (samples / elapsed.count() > best)
+            best = samples / elapsed.count();
+    }
+    std::cout << "  " << name << " @ " << sample_rate << "Hz: " << best << " samples/ms (" <<
+        samples << " samples, " << dropped << " dropped)" << std::endl;
+    return best;
+}
+
+// Resampler filter alone, compared with a scalar dot product
+void bench_dot_product()
+{
+    float history[FIR_RESAMPLER_TAPS];
+    float coefficients[FIR_RESAMPLER_TAPS];
+    for (unsigned int tap = 0; tap < FIR_RESAMPLER_TAPS; tap ++)
+    {
+        history[tap] = (float)tap;
+        coefficients[tap] = 1.0f / (tap + 1);
+    }
+    const unsigned int iterations = 10000000;
+
+    float sum = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (unsigned int itx = 0; itx < iterations; itx ++)
+    {
+        history[itx & (FIR_RESAMPLER_TAPS - 1)] = sum;
+        sum = FirResampler::dot_product(history, coefficients) * 0.5f;
+    }
+    std::chrono::duration<double, std::nano> vector_elapsed = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    for (unsigned int itx = 0; itx < iterations; itx ++)
+    {
+        history[itx & (FIR_RESAMPLER_TAPS - 1)] = sum;
+        float scalar_sum = 0;
+        for (unsigned int tap = 0; tap < FIR_RESAMPLER_TAPS; tap ++)
+            scalar_sum += history[tap] * coefficients[tap];
+        sum = scalar_sum * 0.5f;
+    }
+    std::chrono::duration<double, std::nano> scalar_elapsed = std::chrono::steady_clock::now() - start;
+
+    std::cout << "FIR dot product (" << FIR_RESAMPLER_TAPS << " taps): " <<
+        (vector_elapsed.count() / iterations) << " ns, scalar " <<
+        (scalar_elapsed.count() / iterations) << " ns (result " << sum << ")" << std::endl;
+}
+
+int main(int argc, char *args[])
+{
+    const unsigned int sample_rates[2] = {44100, 48000};
+    for (unsigned int sample_rate : sample_rates)
+    {
+        std::cout << "Output at " << sample_rate << "Hz (real time is " << (sample_rate / 1000.0) << " samples/ms)" << std::endl;
+        bench_output<PointSampler>("Point sampling", sample_rate);
+        bench_output<BlepSynth>("Band-limited + FIR", sample_rate);
+    }
+    bench_dot_product();
+    return 0;
+}
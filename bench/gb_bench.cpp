@@ -0,0 +1,354 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+// Emulator throughput benchmark, written as JSON for tracking over time.
+// Scenarios:
+//   cpu_*    - CPU dispatch on synthetic instruction streams, with the LCD off
+//   ram_*    - RAM reads and writes to each region
+//   ppu      - PPU rendering frames from fixed VRAM, OAM and registers, without the CPU
+//   system_* - test ROMs, from boot, with all components
+// Each scenario runs a fixed amount of emulated work, and the fastest
+// of BENCH_RUNS runs is reported.
+//
+// Usage: gb_bench [-b <BIOS path>] [-d <test ROM directory>] [-o <JSON path>]
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include <string>
+#include <getopt.h>
+#include <string.h>
+
+#include "../src/gameboy.h"
+
+#define BENCH_RUNS 3
+// Emulated cycles per CPU scenario run (~2 seconds)
+#define CPU_BENCH_CYCLES 8388608ULL
+// Accesses per RAM scenario run
+#define RAM_BENCH_ACCESSES 20000000ULL
+// Frames per PPU and system scenario run (~5 seconds)
+#define FRAME_BENCH_FRAMES 300
+
+// Synthetic programs start after the header area, and loop
+// back to the end of their set-up
+#define PROGRAM_START 0x0150
+#define PROGRAM_END 0x3ff0
+// Subroutine called by the branch stream, which returns immediately
+#define SUBROUTINE_ADDRESS 0x0140
+
+#define DEFAULT_BIOS_PATH "./copyright/DMG_ROM.bin"
+#define DEFAULT_ROM_DIRECTORY "./tests/system/roms"
+
+const char *SYSTEM_ROMS[] = {
+    "01-special", "02-interrupts", "04-op_r,imm", "05-op_rp", "06-ld_r,r",
+    "07-jr,jp,call,ret,rst", "08-misc-instrs", "09-op_r,r", "10-bit_ops", "11-op_a,-hl"
+};
+
+struct instruction_stream_t {
+    const char *name;
+    std::vector<uint8_t> body;
+};
+
+// Repeated blocks of instructions, each leaving registers usable by the next
+const instruction_stream_t INSTRUCTION_STREAMS[] = {
+    // ADD A,B; SUB C; AND D; OR E; XOR H; INC A; DEC B; INC C; ADD A,A; ADC A,0x12
+    {"alu", {0x80, 0x91, 0xa2, 0xb3, 0xac, 0x3c, 0x05, 0x0c, 0x87, 0xce, 0x12}},
+    // LD (HL),A; LD A,(HL); LD (HL+),A; LD A,(HL+); LD B,A; LD A,B; LD A,0x55; LD (0xc100),A; LD A,(0xc100)
+    {"load_store", {0x77, 0x7e, 0x22, 0x2a, 0x47, 0x78, 0x3e, 0x55, 0xea, 0x00, 0xc1, 0xfa, 0x00, 0xc1}},
+    // JR +0; CALL subroutine; OR A; JR NZ,+0; JR Z,+0; PUSH BC; POP BC
+    {"branch", {0x18, 0x00, 0xcd, SUBROUTINE_ADDRESS & 0xff, SUBROUTINE_ADDRESS >> 8, 0xb7, 0x20, 0x00, 0x28, 0x00, 0xc5, 0xc1}},
+    // BIT 0,A; SET 0,B; RES 0,C; RL D; SRL E; SWAP A; BIT 7,(HL)
+    {"cb", {0xcb, 0x47, 0xcb, 0xc0, 0xcb, 0x81, 0xcb, 0x12, 0xcb, 0x3b, 0xcb, 0x37, 0xcb, 0x7e}},
+    // Mix of all of the above
+    {"mixed", {0x80, 0x91, 0x77, 0x7e, 0x18, 0x00, 0xcb, 0x47, 0x3c, 0x2a, 0xcd, SUBROUTINE_ADDRESS & 0xff, SUBROUTINE_ADDRESS >> 8, 0xcb, 0x37, 0xa2, 0x47}}
+};
+
+double elapsed_ns(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Fill ROM with the stream's body, repeated, after setting the stack
+// and HL (to work RAM), then jump back to the HL set-up
+void load_program(RAM *ram, const instruction_stream_t &stream)
+{
+    uint8_t *rom = ram->get_ref(0);
+    memset(rom, 0, PROGRAM_END + 3);
+    // JP PROGRAM_START
+    rom[0x0000] = 0xc3;
+    rom[0x0001] = PROGRAM_START & 0xff;
+    rom[0x0002] = PROGRAM_START >> 8;
+    // RET
+    rom[SUBROUTINE_ADDRESS] = 0xc9;
+
+    uint16_t address = PROGRAM_START;
+    // LD SP,0xdffe
+    rom[address ++] = 0x31;
+    rom[address ++] = 0xfe;
+    rom[address ++] = 0xdf;
+    uint16_t loop_address = address;
+    // LD HL,0xc000
+    rom[address ++] = 0x21;
+    rom[address ++] = 0x00;
+    rom[address ++] = 0xc0;
+    while (address + stream.body.size() <= PROGRAM_END)
+    {
+        memcpy(rom + address, stream.body.data(), stream.body.size());
+        address += stream.body.size();
+    }
+    // JP loop
+    rom[address ++] = 0xc3;
+    rom[address ++] = loop_address & 0xff;
+    rom[address ++] = loop_address >> 8;
+}
+
+void bench_cpu(std::ostream &json, const instruction_stream_t &stream)
+{
+    double best_ns = 0;
+    uint64_t instructions = 0;
+    uint64_t cycles = 0;
+    for (unsigned int run_itx = 0; run_itx < BENCH_RUNS; run_itx ++)
+    {
+        std::unique_ptr<GameBoy> gameboy(new GameBoy());
+        // LCD off, so the PPU only runs its register handlers
+        gameboy->get_ram()->set(gameboy->get_ram()->LCDC_CONTROL_ADDR, 0x00);
+        load_program(gameboy->get_ram(), stream);
+        gameboy->set_stop_cycle(CPU_BENCH_CYCLES, nullptr);
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        while (gameboy->run_frame())
+            ;
+        double run_ns = elapsed_ns(start);
+        if (best_ns == 0 || run_ns < best_ns)
+            best_ns = run_ns;
+        instructions = gameboy->get_cpu()->get_instruction_count();
+        cycles = gameboy->get_scheduler()->get_cycle();
+    }
+    json << "    {\"name\": \"cpu_" << stream.name << "\", \"type\": \"cpu\", " <<
+        "\"cycles\": " << cycles << ", \"instructions\": " << instructions << ", " <<
+        "\"host_ns\": " << best_ns << ", \"mips\": " << (instructions * 1000.0 / best_ns) << "}";
+}
+
+// Read and write each address of a region in turn, returning a
+// checksum of values read, so that reads are not optimised away
+uint64_t run_ram(RAM *ram, uint16_t start, uint16_t length, uint64_t accesses)
+{
+    uint64_t checksum = 0;
+    uint16_t offset = 0;
+    for (uint64_t itx = 0; itx < accesses; itx += 2)
+    {
+        uint16_t address = start + offset;
+        uint8_t val = ram->get_val(address);
+        checksum += val;
+        ram->set(address, (uint8_t)(val + 1));
+        if (++ offset == length)
+            offset = 0;
+    }
+    return checksum;
+}
+
+void bench_ram(std::ostream &json, const char *name, uint16_t start, uint16_t length)
+{
+    double best_ns = 0;
+    uint64_t checksum = 0;
+    for (unsigned int run_itx = 0; run_itx < BENCH_RUNS; run_itx ++)
+    {
+        std::unique_ptr<GameBoy> gameboy(new GameBoy());
+        std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+        checksum = run_ram(gameboy->get_ram(), start, length, RAM_BENCH_ACCESSES);
+        double run_ns = elapsed_ns(start_time);
+        if (best_ns == 0 || run_ns < best_ns)
+            best_ns = run_ns;
+    }
+    json << "    {\"name\": \"ram_" << name << "\", \"type\": \"ram\", " <<
+        "\"accesses\": " << RAM_BENCH_ACCESSES << ", \"host_ns\": " << best_ns << ", " <<
+        "\"ns_per_access\": " << (best_ns / RAM_BENCH_ACCESSES) << ", " <<
+        "\"checksum\": " << checksum << "}";
+}
+
+// Tiles, background and window maps and sprites from a fixed seed,
+// with background, window and sprites all enabled
+void load_vram(RAM *ram)
+{
+    uint32_t seed = 0x12345678;
+    uint8_t *memory = ram->get_ref(0);
+    for (uint16_t address = 0x8000; address < 0x9800; address ++)
+    {
+        seed = seed * 1664525 + 1013904223;
+        memory[address] = (uint8_t)(seed >> 24);
+    }
+    for (uint16_t itx = 0; itx < 0x400; itx ++)
+    {
+        memory[0x9800 + itx] = (uint8_t)itx;
+        memory[0x9c00 + itx] = (uint8_t)(itx * 7);
+    }
+    // 40 sprites, across the screen, alternating palettes and flips
+    for (uint16_t sprite = 0; sprite < 40; sprite ++)
+    {
+        memory[0xfe00 + sprite * 4] = (uint8_t)(16 + (sprite * 29) % 144);
+        memory[0xfe00 + sprite * 4 + 1] = (uint8_t)(8 + (sprite * 37) % 160);
+        memory[0xfe00 + sprite * 4 + 2] = (uint8_t)sprite;
+        memory[0xfe00 + sprite * 4 + 3] = (uint8_t)((sprite & 0x07) << 4);
+    }
+
+    ram->set(ram->LCDC_BGP_ADDR, 0xe4);
+    ram->set(ram->LCDC_OBP0_ADDR, 0xd2);
+    ram->set(ram->LCDC_OBP1_ADDR, 0x1b);
+    ram->set(ram->LCDC_SCX, 13);
+    ram->set(ram->LCDC_SCY, 7);
+    ram->set(ram->LCDC_WX_ADDR, 87);
+    ram->set(ram->LCDC_WY_ADDR, 40);
+    ram->set(ram->LCDC_CONTROL_ADDR, 0x00);
+    ram->set(ram->LCDC_CONTROL_ADDR, 0xf3);
+}
+
+void bench_ppu(std::ostream &json)
+{
+    double best_ns = 0;
+    uint64_t frame_hash = 0;
+    for (unsigned int run_itx = 0; run_itx < BENCH_RUNS; run_itx ++)
+    {
+        std::unique_ptr<GameBoy> gameboy(new GameBoy());
+        load_vram(gameboy->get_ram());
+        Scheduler *scheduler = gameboy->get_scheduler();
+
+        // Events are processed as they fall due, without the CPU
+        unsigned int frames = 0;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        while (frames < FRAME_BENCH_FRAMES)
+        {
+            scheduler->advance(scheduler->get_next_event_cycle() - scheduler->get_cycle());
+            SchedulerEvent event;
+            while (scheduler->pop_due_event(event))
+            {
+                if (event == SchedulerEvent::EVENT_VPU && gameboy->get_vpu()->process_event() == VpuEventType::VBLANK)
+                    frames ++;
+                else if (event == SchedulerEvent::EVENT_APU)
+                    gameboy->get_apu()->frame_sequencer_event();
+            }
+        }
+        double run_ns = elapsed_ns(start);
+        if (best_ns == 0 || run_ns < best_ns)
+            best_ns = run_ns;
+        frame_hash = FrameHasher::xxhash64(gameboy->get_vpu()->get_frame_buffers()->get_read_buffer(), sizeof(frame_buffer_t), 0);
+    }
+    json << "    {\"name\": \"ppu\", \"type\": \"ppu\", \"frames\": " << FRAME_BENCH_FRAMES << ", " <<
+        "\"host_ns\": " << best_ns << ", \"frames_per_second\": " << (FRAME_BENCH_FRAMES * 1e9 / best_ns) << ", " <<
+        "\"ns_per_frame\": " << (best_ns / FRAME_BENCH_FRAMES) << ", " <<
+        "\"frame_hash\": \"" << std::hex << std::setw(16) << std::setfill('0') << frame_hash << std::dec << "\"}";
+}
+
+void bench_system(std::ostream &json, const char *bios_path, const std::string &rom_directory, const char *rom)
+{
+    std::string rom_path = rom_directory + "/" + rom + ".gb";
+    double best_ns = 0;
+    uint64_t instructions = 0;
+    uint64_t cycles = 0;
+    unsigned int frames = 0;
+    for (unsigned int run_itx = 0; run_itx < BENCH_RUNS; run_itx ++)
+    {
+        std::unique_ptr<GameBoy> gameboy(new GameBoy());
+        if (! gameboy->load(bios_path, rom_path.c_str()))
+        {
+            json << "    {\"name\": \"system_" << rom << "\", \"type\": \"system\", \"error\": \"unable to open BIOS or ROM\"}";
+            return;
+        }
+
+        frames = 0;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        while (frames < FRAME_BENCH_FRAMES && gameboy->run_frame())
+            frames ++;
+        double run_ns = elapsed_ns(start);
+        if (best_ns == 0 || run_ns < best_ns)
+            best_ns = run_ns;
+        instructions = gameboy->get_cpu()->get_instruction_count();
+        cycles = gameboy->get_scheduler()->get_cycle();
+    }
+    json << "    {\"name\": \"system_" << rom << "\", \"type\": \"system\", " <<
+        "\"frames\": " << frames << ", \"cycles\": " << cycles << ", \"instructions\": " << instructions << ", " <<
+        "\"host_ns\": " << best_ns << ", \"mips\": " << (instructions * 1000.0 / best_ns) << ", " <<
+        "\"frames_per_second\": " << (frames * 1e9 / best_ns) << ", " <<
+        "\"ns_per_frame\": " << (best_ns / frames) << "}";
+}
+
+int main(int argc, char *args[])
+{
+    const char *bios_path = DEFAULT_BIOS_PATH;
+    std::string rom_directory = DEFAULT_ROM_DIRECTORY;
+    const char *output_path = nullptr;
+    int option;
+    while ((option = getopt(argc, args, "b:d:o:")) != -1)
+    {
+        switch (option)
+        {
+            case 'b':
+                bios_path = optarg;
+                break;
+            case 'd':
+                rom_directory = optarg;
+                break;
+            case 'o':
+                output_path = optarg;
+                break;
+            default:
+                std::cout << "Usage: ./gb_bench [-b <BIOS path>] [-d <Test ROM directory>] [-o <JSON path>]" << std::endl;
+                return 1;
+        }
+    }
+
+    std::ostringstream json;
+    json << std::fixed << std::setprecision(3);
+    json << "{\n  \"benchmark\": \"gb_bench\",\n  \"runs\": " << BENCH_RUNS << ",\n  \"scenarios\": [\n";
+
+    // Emulator output is discarded whilst scenarios run, so that
+    // only the results are written
+    std::streambuf *cout_buffer = std::cout.rdbuf(nullptr);
+
+    for (const instruction_stream_t &stream : INSTRUCTION_STREAMS)
+    {
+        bench_cpu(json, stream);
+        json << ",\n";
+    }
+
+    bench_ram(json, "work_ram", 0xc000, 0x2000);
+    json << ",\n";
+    bench_ram(json, "high_ram", 0xff80, 0x7f);
+    json << ",\n";
+    bench_ram(json, "vram", 0x8000, 0x2000);
+    json << ",\n";
+    // Timer and interrupt flag registers, through their IO handlers
+    bench_ram(json, "io", 0xff04, 0x0c);
+    json << ",\n";
+
+    bench_ppu(json);
+
+    for (const char *rom : SYSTEM_ROMS)
+    {
+        json << ",\n";
+        bench_system(json, bios_path, rom_directory, rom);
+    }
+    json << "\n  ]\n}\n";
+
+    std::cout.rdbuf(cout_buffer);
+    std::cout.clear();
+
+    if (output_path == nullptr)
+    {
+        std::cout << json.str();
+        return 0;
+    }
+    std::ofstream output(output_path, std::ios::trunc);
+    output << json.str();
+    if (! output.good())
+    {
+        std::cout << "Unable to write results: " << output_path << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,158 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+// Microbenchmark comparing per-cycle polling of peripherals with
+// running until the next event from the scheduler.
+
+#include <iostream>
+#include <chrono>
+#include <stdlib.h>
+
+#include "../src/scheduler.h"
+
+// Emulated cycles per run (~60 frames)
+#define BENCH_CYCLES 4213440ULL
+#define BENCH_RUNS 5
+
+// Approximate mode lengths and timer period used by the emulator
+const uint64_t VPU_MODE_LENGTHS[3] = {80, 172, 204};
+const uint64_t TIMER_PERIOD = 976;
+
+// Work done by the CPU on a cycle, which cannot be optimised away
+static inline void cpu_cycle(uint64_t &state)
+{
+    state = (state * 6364136223846793005ULL) + 1442695040888963407ULL;
+}
+
+// Peripheral with its own cycle counter, ticked every cycle.
+// Ticks are not inlined, as peripherals are in separate
+// translation units in the emulator.
+class PolledPeripheral {
+public:
+    PolledPeripheral(const uint64_t *lengths, unsigned int length_count) :
+        lengths(lengths), length_count(length_count), index(0), cycle(0), next_cycle(lengths[0]) {};
+
+    __attribute__((noinline)) bool tick() {
+        this->cycle ++;
+        if (this->cycle < this->next_cycle)
+            return false;
+        this->index = (this->index + 1) % this->length_count;
+        this->next_cycle += this->lengths[this->index];
+        return true;
+    };
+
+private:
+    const uint64_t *lengths;
+    unsigned int length_count;
+    unsigned int index;
+    uint64_t cycle;
+    uint64_t next_cycle;
+};
+
+// Each peripheral is ticked every cycle, checking its own deadline
+uint64_t run_polling(uint64_t &state, bool halted)
+{
+    PolledPeripheral vpu(VPU_MODE_LENGTHS, 3);
+    PolledPeripheral timer(&TIMER_PERIOD, 1);
+    uint64_t events = 0;
+
+    for (uint64_t cycle = 1; cycle <= BENCH_CYCLES; cycle ++)
+    {
+        if (! halted)
+            cpu_cycle(state);
+        events += timer.tick();
+        events += vpu.tick();
+    }
+    return events;
+}
+
+// CPU runs until the earliest deadline, then due events are processed.
+// Whilst halted, the CPU skips directly to the deadline.
+uint64_t run_scheduled(uint64_t &state, bool halted)
+{
+    Scheduler scheduler;
+    unsigned int vpu_mode = 0;
+    uint64_t events = 0;
+    scheduler.schedule(SchedulerEvent::EVENT_VPU, VPU_MODE_LENGTHS[0]);
+    scheduler.schedule(SchedulerEvent::EVENT_TIMER, TIMER_PERIOD);
+
+    while (scheduler.get_cycle() < BENCH_CYCLES)
+    {
+        if (halted)
+            scheduler.advance(scheduler.get_next_event_cycle() - scheduler.get_cycle());
+        while (scheduler.get_cycle() < scheduler.get_next_event_cycle())
+        {
+            cpu_cycle(state);
+            scheduler.advance(1);
+        }
+
+        SchedulerEvent event;
+        while (scheduler.pop_due_event(event))
+        {
+            events ++;
+            if (event == SchedulerEvent::EVENT_VPU)
+            {
+                vpu_mode = (vpu_mode + 1) % 3;
+                scheduler.schedule(event, scheduler.get_cycle() + VPU_MODE_LENGTHS[vpu_mode]);
+            }
+            else
+            {
+                scheduler.schedule(event, scheduler.get_cycle() + TIMER_PERIOD);
+            }
+        }
+    }
+    return events;
+}
+
+// Cost of rescheduling and popping events, without any CPU work
+double bench_event_cost()
+{
+    Scheduler scheduler;
+    const uint64_t iterations = 10000000;
+    for (unsigned int event = 0; event < SchedulerEvent::EVENT_COUNT; event ++)
+        scheduler.schedule((SchedulerEvent)event, event * 7);
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (uint64_t itx = 0; itx < iterations; itx ++)
+    {
+        SchedulerEvent event;
+        scheduler.advance(scheduler.get_next_event_cycle() - scheduler.get_cycle());
+        if (scheduler.pop_due_event(event))
+            scheduler.schedule(event, scheduler.get_cycle() + 1 + (itx % 97));
+    }
+    std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - start;
+    return (double)elapsed.count() / iterations;
+}
+
+double bench_loop(const char *name, uint64_t (*run)(uint64_t&, bool), bool halted)
+{
+    uint64_t state = 1;
+    uint64_t events = 0;
+    double best = 0;
+    for (unsigned int run_itx = 0; run_itx < BENCH_RUNS; run_itx ++)
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        events = run(state, halted);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        double mhz = (BENCH_CYCLES / elapsed.count()) / 1000000.0;
+        if (mhz > best)
+            best = mhz;
+    }
+    std::cout << name << ": " << best << " M cycles/s (" << events << " events, state " << (state & 0xff) << ")" << std::endl;
+    return best;
+}
+
+int main(int argc, char *args[])
+{
+    for (unsigned int halted = 0; halted < 2; halted ++)
+    {
+        std::cout << (halted ? "CPU halted" : "CPU running") << std::endl;
+        double polling = bench_loop("  Polling", run_polling, halted);
+        double scheduled = bench_loop("  Scheduled", run_scheduled, halted);
+        std::cout << "  Speed-up: " << (scheduled / polling) << "x" << std::endl;
+    }
+    std::cout << "Reschedule + pop: " << bench_event_cost() << " ns/event" << std::endl;
+    return 0;
+}
@@ -7,22 +7,153 @@
 #include <string>
 #include <signal.h>
 #include <getopt.h>
+#include <thread>
+#include <chrono>
+#include <fstream>
 
 #include "./helper.h"
-#include "./ram.h"
-#include "./vpu.h"
-#include "./cpu.h"
+#include "./gameboy.h"
+#include "./input_script.h"
+#include "./serial_file_sink.h"
+#include "./serial_buffer_sink.h"
+#include "./point_sampler.h"
+#include "./blep_synth.h"
+#include "./audio_writer.h"
+#include "./sdl_audio.h"
 #include "./test_runner.h"
+#include "./runtime_stats.h"
+#include "./stats_reporter.h"
+#include "./display.h"
+#include "./frame_pacer.h"
+#include "./batch_runner.h"
+#include "./rewind_buffer.h"
+#include "./movie.h"
 
 #define APP_NAME "GameBoy Emulator"
+#define DEFAULT_BIOS_PATH "./copyright/DMG_ROM.bin"
 
 #define RUN_TESTS 0
-#define DISABLE_VPU 0
 
+// Hotkeys - rewind whilst held, toggle pause and step one frame whilst paused
+#define REWIND_KEY SDLK_r
+#define PAUSE_KEY SDLK_p
+#define STEP_KEY SDLK_n
+// Time between checking for input whilst paused
+#define PAUSE_POLL_INTERVAL std::chrono::milliseconds(10)
+
+// Run emulation until stopped, either on the main thread (headless)
+// or on its own thread, whilst the main thread presents frames
+void run_emulation(GameBoy *gameboy, Display *display, InputScript *input_script, FramePacer *frame_pacer, RewindBuffer *rewind_buffer, Movie *movie)
+{
+    bool rewinding = false;
+    bool paused = false;
+    bool step = false;
+    while (true)
+    {
+        if (paused && ! step && ! rewinding)
+            std::this_thread::sleep_for(PAUSE_POLL_INTERVAL);
+        else
+        {
+            // Each rewound snapshot is shown by running the frame after it
+            if (rewinding)
+                rewind_buffer->rewind();
+            if (movie != nullptr)
+                movie->start_frame();
+            if (! gameboy->run_frame())
+                break;
+            if (movie != nullptr)
+                movie->end_frame();
+            // Snapshots are not taken whilst rewinding, as each would
+            // replace the one just stepped back from
+            if (rewind_buffer != nullptr && ! rewinding)
+                rewind_buffer->frame();
+            frame_pacer->wait_for_frame();
+            step = false;
+        }
+
+        // Handle input from script and display once per frame
+        if (input_script != nullptr)
+            input_script->apply(gameboy->get_vpu()->get_frame_count(), gameboy->get_joypad());
+        if (display != nullptr)
+        {
+            input_event_t input_event;
+            while (display->poll_event(input_event))
+            {
+                // Emulation is already stopped, so leave pause to exit
+                if (input_event.type == InputEventType::INPUT_QUIT)
+                    paused = false;
+                else if (input_event.type == InputEventType::INPUT_KEY_DOWN && input_event.key == REWIND_KEY)
+                    rewinding = rewind_buffer != nullptr;
+                else if (input_event.type == InputEventType::INPUT_KEY_UP && input_event.key == REWIND_KEY)
+                    rewinding = false;
+                else if (input_event.type == InputEventType::INPUT_KEY_DOWN && input_event.key == PAUSE_KEY)
+                    paused = ! paused;
+                else if (input_event.type == InputEventType::INPUT_KEY_DOWN && input_event.key == STEP_KEY)
+                    step = true;
+                else if (input_event.type == InputEventType::INPUT_BUTTON_DOWN)
+                    gameboy->get_joypad()->set_button((JoypadButton)input_event.key, true);
+                else if (input_event.type == InputEventType::INPUT_BUTTON_UP)
+                    gameboy->get_joypad()->set_button((JoypadButton)input_event.key, false);
+            }
+        }
+    }
+
+    if (display != nullptr)
+        display->stop();
+}
 
 int main(int argc, char *args[])
 {
     arguments_t arguments = {{0, 0, 0, 0}};
+    // Frame skip - -1 for auto, 0 to render all frames
+    int frame_skip = 0;
+    bool frame_skip_screenshot = false;
+    bool print_stats = false;
+    bool headless = false;
+    // Video recording output and number of frames per recorded frame
+    char *video_path = nullptr;
+    unsigned int video_interval = 1;
+    // Frame hash log and expected hashes
+    FrameHasher *frame_hasher = nullptr;
+    char *hash_log_path = nullptr;
+    unsigned int hash_log_interval = 1;
+    // Speed multiplier, 0 for uncapped, defaulting to
+    // real time with a display and uncapped when headless
+    double speed = -1;
+    // Scripted joypad input
+    InputScript *input_script = nullptr;
+    // Serial output, and patterns to match against it
+    SerialFileSink *serial_file = nullptr;
+    SerialBufferSink *serial_buffer = nullptr;
+    // Audio output - 'sdl', 'null' or WAV file path,
+    // defaulting to SDL with a display and none when headless
+    const char *audio_output = nullptr;
+    unsigned int audio_sample_rate = AUDIO_SAMPLE_RATE;
+    // Point sample APU output, rather than band-limited synthesis
+    bool audio_point_sampling = false;
+    // Target queued audio latency (ms), when pacing against the audio
+    // device, or 0 to pace against video timing
+    double audio_latency = 50;
+    // Host colours for each shade
+    uint32_t color_scheme[4];
+    memcpy(color_scheme, COLOR_SCHEME_GREY, sizeof(color_scheme));
+    // Batch manifest and number of threads to run it on, defaulting to one per core
+    char *batch_path = nullptr;
+    unsigned int batch_threads = std::thread::hardware_concurrency();
+    // Save state to load before running, and to save once stopped
+    char *load_state_path = nullptr;
+    char *save_state_path = nullptr;
+    // Rewind memory budget (MB), 0 to disable, and frames between snapshots
+    unsigned int rewind_budget = 0;
+    unsigned int rewind_interval = REWIND_DEFAULT_INTERVAL;
+    // Movie to record or replay, and frames between state hash checkpoints
+    char *record_movie_path = nullptr;
+    char *replay_movie_path = nullptr;
+    unsigned int movie_checkpoint_interval = MOVIE_DEFAULT_CHECKPOINT_INTERVAL;
+    // Seconds between printing runtime stats, 0 to only print on SIGUSR1,
+    // and path to write stats to as JSON on exit
+    double stats_interval = 0;
+    char *stats_json_path = nullptr;
 
 
     for(;;)
@@ -31,9 +162,52 @@ int main(int argc, char *args[])
         // -h - help/usage
         // -f - rom file path
         // -b - bios file path
-        // -s - screenshot filepath
-        // -t - screenshot after X CPU ticks
-        switch(getopt(argc, args, "hf:b:s:t:"))
+        // -s - screenshot filepath (.bmp, .ppm or .raw for shade indexes)
+        // -t - screenshot (if -s is given) and stop after X CPU ticks
+        // -k - frame skip (number of frames, 'auto' or 'screenshot')
+        // -S - print runtime stats on exit
+        // -c - colour scheme ('grey', 'green' or 4 comma-separated RRGGBB colours)
+        // -H - headless, run without a display
+        // -r - record video to file (.y4m or raw RGB) or '|command'
+        // -R - record every N frames
+        // -x - log frame hashes to file ('-' for stdout)
+        // -y - log hash of every N frames
+        // -X - expected frame hash, '<frame>:<hash>' must be seen by frame or '!<hash>' must not be seen
+        // -p - speed multiplier (e.g. 1, 2, 0.5) or 'max' for uncapped
+        // -i - joypad input script
+        // -o - write serial output to file ('-' for stdout)
+        // -m - pass once serial output contains text (e.g. 'Passed')
+        // -M - fail once serial output contains text (e.g. 'Failed')
+        // -a - audio output ('sdl', 'null' or WAV file path)
+        // -A - audio sample rate (e.g. 44100, 48000)
+        // -L - low-cost audio, point sampling rather than band-limited synthesis
+        // -P - pace against audio device with target latency in ms, or 'video' for video timing
+        // --batch - run each ROM in manifest headless, in parallel (-t sets the default tick limit)
+        // -j - number of threads for batch
+        // --load-state - start from save state
+        // --save-state - save state once stopped
+        // --rewind - keep rewind history, within budget in MB
+        // --rewind-interval - frames between rewind snapshots
+        // --record-movie - record input to movie file
+        // --replay-movie - replay movie headless and uncapped, failing if it diverges
+        // --movie-checkpoints - frames between state hash checkpoints when recording, 0 for none
+        // --stats - print runtime stats every N seconds (stats are always printed on SIGUSR1)
+        // --stats-json - write runtime stats as JSON on exit ('-' for stdout)
+        static const struct option long_options[] = {
+            {"batch", required_argument, nullptr, 'B'},
+            {"load-state", required_argument, nullptr, 'l'},
+            {"save-state", required_argument, nullptr, 'w'},
+            {"rewind", required_argument, nullptr, 'e'},
+            {"rewind-interval", required_argument, nullptr, 'E'},
+            {"record-movie", required_argument, nullptr, 'v'},
+            {"replay-movie", required_argument, nullptr, 'V'},
+            {"movie-checkpoints", required_argument, nullptr, 'C'},
+            {"stats", required_argument, nullptr, 'T'},
+            {"stats-json", required_argument, nullptr, 'J'},
+            {nullptr, 0, nullptr, 0}
+        };
+        int option = getopt_long(argc, args, "hf:b:s:t:k:Sc:Hr:R:x:y:X:p:i:o:m:M:a:A:LP:j:", long_options, nullptr);
+        switch(option)
         {
             case 'f':
                 strncpy(arguments.rom_path, optarg, sizeof(arguments.rom_path) - 1);
@@ -47,11 +221,160 @@ int main(int argc, char *args[])
             case 't':
                 arguments.screenshot_ticks = atoi(optarg);
                 continue;
+            case 'k':
+                if (strcmp(optarg, "auto") == 0)
+                    frame_skip = -1;
+                else if (strcmp(optarg, "screenshot") == 0)
+                    frame_skip_screenshot = true;
+                else
+                    frame_skip = atoi(optarg);
+                continue;
+            case 'S':
+                print_stats = true;
+                continue;
+            case 'H':
+                headless = true;
+                continue;
+            case 'r':
+                video_path = optarg;
+                continue;
+            case 'R':
+                video_interval = atoi(optarg);
+                continue;
+            case 'p':
+                speed = strcmp(optarg, "max") == 0 ? 0 : atof(optarg);
+                if (speed < 0)
+                {
+                    std::cout << "Invalid speed: " << optarg << std::endl;
+                    exit(1);
+                }
+                continue;
+            case 'i':
+                input_script = new InputScript();
+                if (! input_script->load(optarg))
+                    exit(1);
+                continue;
+            case 'a':
+                audio_output = optarg;
+                continue;
+            case 'A':
+                audio_sample_rate = atoi(optarg);
+                if (audio_sample_rate < 8000 || audio_sample_rate > 192000)
+                {
+                    std::cout << "Invalid sample rate: " << optarg << std::endl;
+                    exit(1);
+                }
+                continue;
+            case 'L':
+                audio_point_sampling = true;
+                continue;
+            case 'P':
+                audio_latency = strcmp(optarg, "video") == 0 ? 0 : atof(optarg);
+                if (audio_latency < 0 || (audio_latency == 0 && strcmp(optarg, "video") != 0))
+                {
+                    std::cout << "Invalid audio latency: " << optarg << std::endl;
+                    exit(1);
+                }
+                continue;
+            case 'o':
+                serial_file = new SerialFileSink();
+                if (! serial_file->open(optarg))
+                    exit(1);
+                continue;
+            case 'm':
+            case 'M':
+                if (serial_buffer == nullptr)
+                    serial_buffer = new SerialBufferSink();
+                serial_buffer->add_pattern(optarg, option == 'm' ? SerialResult::SERIAL_PASSED : SerialResult::SERIAL_FAILED);
+                continue;
+            case 'x':
+                hash_log_path = optarg;
+                continue;
+            case 'y':
+                hash_log_interval = atoi(optarg);
+                continue;
+            case 'X':
+                if (frame_hasher == nullptr)
+                    frame_hasher = new FrameHasher();
+                if (! frame_hasher->add_expected(optarg))
+                {
+                    std::cout << "Invalid expected frame hash: " << optarg << std::endl;
+                    exit(1);
+                }
+                continue;
+            case 'B':
+                batch_path = optarg;
+                continue;
+            case 'l':
+                load_state_path = optarg;
+                continue;
+            case 'w':
+                save_state_path = optarg;
+                continue;
+            case 'e':
+                rewind_budget = atoi(optarg);
+                if (rewind_budget == 0)
+                {
+                    std::cout << "Invalid rewind budget: " << optarg << std::endl;
+                    exit(1);
+                }
+                continue;
+            case 'E':
+                rewind_interval = atoi(optarg);
+                if (rewind_interval == 0)
+                {
+                    std::cout << "Invalid rewind interval: " << optarg << std::endl;
+                    exit(1);
+                }
+                continue;
+            case 'v':
+                record_movie_path = optarg;
+                continue;
+            case 'V':
+                replay_movie_path = optarg;
+                continue;
+            case 'C':
+                movie_checkpoint_interval = atoi(optarg);
+                continue;
+            case 'T':
+                stats_interval = atof(optarg);
+                if (stats_interval <= 0)
+                {
+                    std::cout << "Invalid stats interval: " << optarg << std::endl;
+                    exit(1);
+                }
+                continue;
+            case 'J':
+                stats_json_path = optarg;
+                continue;
+            case 'j':
+                batch_threads = atoi(optarg);
+                if (batch_threads == 0)
+                {
+                    std::cout << "Invalid thread count: " << optarg << std::endl;
+                    exit(1);
+                }
+                continue;
+            case 'c':
+                if (strcmp(optarg, "grey") == 0)
+                    memcpy(color_scheme, COLOR_SCHEME_GREY, sizeof(color_scheme));
+                else if (strcmp(optarg, "green") == 0)
+                    memcpy(color_scheme, COLOR_SCHEME_GREEN, sizeof(color_scheme));
+                else if (sscanf(optarg, "%6x,%6x,%6x,%6x", &color_scheme[0], &color_scheme[1], &color_scheme[2], &color_scheme[3]) == 4)
+                    for (unsigned int shade = 0; shade < 4; shade ++)
+                        color_scheme[shade] |= 0xff000000;
+                else
+                {
+                    std::cout << "Invalid colour scheme: " << optarg << std::endl;
+                    exit(1);
+                }
+                continue;
 
             case '?':
             case 'h':
             default :
-                std::cout << "Usage: ./GameboyEmulator -b <BIOS path> -f <ROM path> [-s <Screenshot filepath> -t <Screenshot After X CPU ticks>]" << std::endl;
+                std::cout << "Usage: ./GameboyEmulator -b <BIOS path> -f <ROM path> [-s <Screenshot filepath> -t <Screenshot After X CPU ticks>] [-k <Frame skip count|auto|screenshot>] [-S] [-c <grey|green|RRGGBB,RRGGBB,RRGGBB,RRGGBB>] [-H] [-r <Video path|'|command'> [-R <Record every N frames>]] [-x <Hash log path> [-y <Hash every N frames>]] [-X <frame:hash|!hash> ...] [-p <Speed multiplier|max>] [-i <Input script path>] [-o <Serial output path>] [-m <Serial pass text> ...] [-M <Serial fail text> ...] [-a <sdl|null|WAV path>] [-A <Sample rate>] [-L] [-P <Audio latency ms|video>] [--load-state <Path>] [--save-state <Path>] [--rewind <Budget MB> [--rewind-interval <Frames>]] [--record-movie <Path> [--movie-checkpoints <Frames>]] [--replay-movie <Path>] [--stats <Seconds>] [--stats-json <Path|->]" << std::endl <<
+                    "       ./GameboyEmulator --batch <Manifest path> [-j <Threads>] [-b <BIOS path>] [-t <Default max CPU ticks>]" << std::endl;
                 exit(1);
                 break;
 
@@ -64,22 +387,59 @@ int main(int argc, char *args[])
 
     
     Helper::init();
-    RAM *ram_inst = new RAM();
-    VPU *vpu_inst = new VPU(ram_inst);
-    CPU *cpu_inst = new CPU(ram_inst, vpu_inst);
+
+    // Frames are only skipped up to the screenshot, which needs a tick count
+    if (frame_skip_screenshot && ! arguments.screenshot_ticks)
+    {
+        std::cout << "Frame skip 'screenshot' requires -t" << std::endl;
+        exit(1);
+    }
+    // Rewinding would jump the state being recorded, and input is
+    // taken from the movie whilst replaying
+    if ((record_movie_path != nullptr || replay_movie_path != nullptr) && rewind_budget)
+    {
+        std::cout << "Movies cannot be combined with rewind" << std::endl;
+        exit(1);
+    }
+    if (replay_movie_path != nullptr && input_script != nullptr)
+    {
+        std::cout << "Movie replay cannot be combined with an input script" << std::endl;
+        exit(1);
+    }
+    // Replays run as fast as possible, without a display
+    if (replay_movie_path != nullptr)
+    {
+        headless = true;
+        speed = 0;
+    }
+
+    // Batch runs its own instances, without a display or audio
+    if (batch_path != nullptr)
+    {
+        BatchRunner batch(strlen(arguments.bios_path) != 0 ? arguments.bios_path : DEFAULT_BIOS_PATH,
+                          arguments.screenshot_ticks > 0 ? arguments.screenshot_ticks : BATCH_DEFAULT_MAX_TICKS);
+        if (! batch.load(batch_path))
+            return 1;
+        return batch.run(batch_threads) ? 0 : 1;
+    }
+    GameBoy *gameboy = new GameBoy();
+    VPU *vpu_inst = gameboy->get_vpu();
+    if (serial_file != nullptr)
+        gameboy->get_serial()->add_sink(serial_file);
+    if (serial_buffer != nullptr)
+        gameboy->set_serial_result(serial_buffer);
 
 #if RUN_TESTS
     // Run tests
-    TestRunner *rt = new TestRunner(vpu_inst, cpu_inst, ram_inst);
+    TestRunner *rt = new TestRunner(vpu_inst, gameboy->get_cpu(), gameboy->get_ram());
     rt->run_tests();
 #endif
-    cpu_inst->reset_state();
 
     // Load bios/RAM
     if (strlen(arguments.bios_path) == 0)
     {
         //char bios_path[] = "./matt-test-daa.rom";
-        char bios_path[] = "./copyright/DMG_ROM.bin";
+        char bios_path[] = DEFAULT_BIOS_PATH;
         strncpy(arguments.bios_path, bios_path, sizeof(arguments.bios_path) - 1);
     }
     if (strlen(arguments.rom_path) == 0)
@@ -106,36 +466,189 @@ int main(int argc, char *args[])
     // 10-bit ops.gb - passed
     // 11-op a,(hl).gb - passed
 
-    ram_inst->load_bios(&arguments);
-    ram_inst->load_rom(&arguments);
+    if (! gameboy->load(arguments.bios_path, arguments.rom_path))
+        exit(1);
+    if (load_state_path != nullptr && ! gameboy->load_state_file(load_state_path))
+        exit(1);
+
+    vpu_inst->set_color_scheme(color_scheme);
+
+    if (arguments.screenshot_ticks)
+        gameboy->set_stop_cycle(arguments.screenshot_ticks, arguments.screenshot_path);
+
+    // Replays stop where recording stopped, in place of any stop cycle
+    Movie *movie = nullptr;
+    if (replay_movie_path != nullptr)
+    {
+        movie = new Movie();
+        if (! movie->load(replay_movie_path) || ! movie->start_replay(gameboy))
+            exit(1);
+    }
+    else if (record_movie_path != nullptr)
+    {
+        movie = new Movie();
+        movie->start_recording(gameboy, movie_checkpoint_interval);
+    }
+
+    // Setup frame skip
+    if (frame_skip_screenshot)
+        vpu_inst->frame_skip.set_target_cycle(arguments.screenshot_ticks);
+    else if (frame_skip == -1)
+        vpu_inst->frame_skip.set_auto();
+    else if (frame_skip > 0)
+        vpu_inst->frame_skip.set_fixed(frame_skip);
+
+    VideoRecorder *video_recorder = nullptr;
+    if (video_path != nullptr)
+    {
+        video_recorder = new VideoRecorder();
+        if (! video_recorder->start(video_path, video_interval))
+            exit(1);
+        vpu_inst->set_video_recorder(video_recorder);
+    }
 
-    // run the program as long as the window is open
-    while (cpu_inst->is_running())
+    if (hash_log_path != nullptr)
     {
-        cpu_inst->tick();
+        if (frame_hasher == nullptr)
+            frame_hasher = new FrameHasher();
+        if (! frame_hasher->open_log(hash_log_path, hash_log_interval))
+            exit(1);
+    }
+    if (frame_hasher != nullptr)
+        gameboy->set_frame_hasher(frame_hasher);
 
-#if ! DISABLE_VPU
-        switch (vpu_inst->tick())
+    if (audio_output == nullptr && ! headless)
+        audio_output = "sdl";
+    AudioRing *audio_ring = nullptr;
+    RingOutput *audio_sampler = nullptr;
+    SdlAudio *sdl_audio = nullptr;
+    AudioWriter *audio_writer = nullptr;
+    if (audio_output != nullptr)
+    {
+        audio_ring = new AudioRing();
+        if (audio_point_sampling)
+            audio_sampler = new PointSampler(audio_ring, audio_sample_rate);
+        else
+            audio_sampler = new BlepSynth(audio_ring, audio_sample_rate);
+        if (strcmp(audio_output, "sdl") == 0)
         {
-            case VpuEventType::EXIT:
-                cpu_inst->stop();
-                break;
-            default:
-                break;
+            sdl_audio = new SdlAudio(audio_ring);
+            // Continue without sound, if there is no audio device
+            if (sdl_audio->start(audio_sample_rate))
+                gameboy->get_apu()->set_output(audio_sampler);
+            else
+            {
+                delete sdl_audio;
+                sdl_audio = nullptr;
+            }
         }
-#endif
+        else
+        {
+            audio_writer = new AudioWriter(audio_ring);
+            if (! audio_writer->start(audio_output, audio_sample_rate))
+                exit(1);
+            // Writer is not real-time, so wait for it rather than dropping samples
+            audio_sampler->set_blocking(true);
+            gameboy->get_apu()->set_output(audio_sampler);
+        }
+    }
+
+    FramePacer *frame_pacer = new FramePacer(gameboy->get_stats());
+    frame_pacer->set_speed(speed < 0 ? (headless ? 0 : 1) : speed);
+    // Audio device's clock can only pace real time emulation
+    if (sdl_audio != nullptr && frame_pacer->get_speed() == 1 && audio_latency > 0)
+        frame_pacer->set_audio_sync(audio_ring, audio_sampler, audio_sample_rate, audio_latency);
+
+    RewindBuffer *rewind_buffer = nullptr;
+    if (rewind_budget)
+    {
+        rewind_buffer = new RewindBuffer(gameboy, rewind_interval, (size_t)rewind_budget * 1024 * 1024);
+        rewind_buffer->capture();
+    }
+
+    StatsReporter *stats_reporter = new StatsReporter(gameboy->get_stats());
+    stats_reporter->start(stats_interval);
+
+    if (headless)
+    {
+        run_emulation(gameboy, nullptr, input_script, frame_pacer, rewind_buffer, movie);
+    }
+    else
+    {
+        // Display must run on the main thread, so run emulation on another thread
+        Display *display = new Display(gameboy);
+        std::thread emulation_thread(run_emulation, gameboy, display, input_script, frame_pacer, rewind_buffer, movie);
+        display->run();
+        emulation_thread.join();
+        delete display;
+    }
+    stats_reporter->stop();
+    delete stats_reporter;
+
+    // Failures are reported once outputs below have been finished
+    bool failed = false;
+    if (save_state_path != nullptr && ! gameboy->save_state_file(save_state_path))
+        failed = true;
+    if (record_movie_path != nullptr && ! movie->finish_recording(record_movie_path))
+        failed = true;
+    if (replay_movie_path != nullptr && ! movie->finish_replay())
+        failed = true;
 
-        // Check for screenshot
-        if (arguments.screenshot_ticks && arguments.screenshot_ticks == cpu_inst->get_tick_counter())
+    // Wait for screenshots and video to be written
+    vpu_inst->screenshots.finish();
+    if (video_recorder != nullptr)
+    {
+        vpu_inst->set_video_recorder(nullptr);
+        delete video_recorder;
+    }
+
+    if (sdl_audio != nullptr)
+    {
+        sdl_audio->stop();
+        std::cout << "Audio: " << std::dec << audio_sampler->get_dropped_frames() << " samples dropped" << std::endl;
+        frame_pacer->print_audio_stats();
+    }
+    // Display and audio have shut down their own subsystems
+    SDL_Quit();
+    if (audio_writer != nullptr)
+        audio_writer->finish();
+
+    if (print_stats)
+        gameboy->get_stats()->print();
+    if (stats_json_path != nullptr)
+    {
+        if (strcmp(stats_json_path, "-") == 0)
+            gameboy->get_stats()->write_json(std::cout);
+        else
         {
-            std::cout << "Capturing Screenshot" << std::endl;
-            vpu_inst->capture_screenshot(arguments.screenshot_path);
-            cpu_inst->stop();
+            std::ofstream stats_file(stats_json_path, std::ios::trunc);
+            gameboy->get_stats()->write_json(stats_file);
+            if (! stats_file.good())
+            {
+                std::cout << "Unable to write stats: " << stats_json_path << std::endl;
+                failed = true;
+            }
         }
+    }
+    if (rewind_buffer != nullptr)
+        rewind_buffer->print_stats();
 
+    if (frame_hasher != nullptr)
+    {
+        frame_hasher->finish();
+        if (frame_hasher->get_result() == FrameHashResult::HASH_FAILED)
+            return 1;
     }
 
-    vpu_inst->tear_down();
+    if (serial_file != nullptr)
+        delete serial_file;
+    if (serial_buffer != nullptr)
+    {
+        if (serial_buffer->get_result() == SerialResult::SERIAL_PENDING)
+            std::cout << "Serial output did not match any pattern" << std::endl;
+        if (serial_buffer->get_result() != SerialResult::SERIAL_PASSED)
+            return 1;
+    }
 
-    return 0;
+    return failed ? 1 : 0;
 }
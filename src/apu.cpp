@@ -0,0 +1,225 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+#include "apu.h"
+
+#include <string.h>
+
+Apu::Apu(RAM *ram, Scheduler *scheduler) : square1(true), square2(false)
+{
+    this->scheduler = scheduler;
+    this->output = nullptr;
+    this->channels[0] = &this->square1;
+    this->channels[1] = &this->square2;
+    this->channels[2] = &this->wave;
+    this->channels[3] = &this->noise;
+
+    memset(this->registers, 0, sizeof(this->registers));
+    this->powered = false;
+    this->frame_sequencer_step = 0;
+    this->level_left = 0;
+    this->level_right = 0;
+
+    for (unsigned int address = this->NR10_ADDR; address <= this->REGISTER_END_ADDR; address ++)
+        ram->register_io_handler(address, this);
+
+    this->next_frame_sequencer_cycle = this->scheduler->get_cycle() + this->FRAME_SEQUENCER_PERIOD;
+    this->scheduler->schedule(SchedulerEvent::EVENT_APU, this->next_frame_sequencer_cycle);
+}
+
+void Apu::set_output(ApuOutput *output)
+{
+    this->output = output;
+    if (this->output != nullptr)
+        this->sync_output();
+}
+
+void Apu::sync_output()
+{
+    // Channels are not stepped without an output, so waveforms
+    // restart from the current cycle rather than catching up
+    uint64_t cycle = this->scheduler->get_cycle();
+    for (auto channel : this->channels)
+        channel->resync(cycle);
+    this->output->set_cycle(cycle);
+    this->output->set_level(cycle, this->level_left, this->level_right);
+    this->update_level(cycle);
+}
+
+void Apu::save_state(apu_state_t &state)
+{
+    memcpy(state.registers, this->registers, sizeof(state.registers));
+    state.powered = this->powered;
+    state.frame_sequencer_step = this->frame_sequencer_step;
+    state.next_frame_sequencer_cycle = this->next_frame_sequencer_cycle;
+    state.level_left = this->level_left;
+    state.level_right = this->level_right;
+    for (unsigned int itx = 0; itx < 4; itx ++)
+        this->channels[itx]->save_state(state.channels[itx]);
+}
+
+void Apu::load_state(const apu_state_t &state)
+{
+    memcpy(this->registers, state.registers, sizeof(this->registers));
+    this->powered = state.powered;
+    this->frame_sequencer_step = state.frame_sequencer_step;
+    this->next_frame_sequencer_cycle = state.next_frame_sequencer_cycle;
+    this->level_left = state.level_left;
+    this->level_right = state.level_right;
+    for (unsigned int itx = 0; itx < 4; itx ++)
+        this->channels[itx]->load_state(state.channels[itx]);
+
+    if (this->output != nullptr)
+        this->sync_output();
+}
+
+void Apu::run_until(uint64_t cycle)
+{
+    if (this->output == nullptr)
+        return;
+
+    while (true)
+    {
+        uint64_t step_cycle = UINT64_MAX;
+        for (auto channel : this->channels)
+            if (channel->get_next_step_cycle() < step_cycle)
+                step_cycle = channel->get_next_step_cycle();
+        if (step_cycle > cycle)
+            break;
+
+        for (auto channel : this->channels)
+            if (channel->get_next_step_cycle() == step_cycle)
+                channel->step();
+        this->update_level(step_cycle);
+    }
+    this->output->run_until(cycle);
+}
+
+void Apu::update_level(uint64_t cycle)
+{
+    if (this->output == nullptr)
+        return;
+
+    // NR51 selects channels for each side, by bit 4-7 (left) and 0-3 (right)
+    uint8_t panning = this->registers[this->NR51_ADDR - this->NR10_ADDR];
+    int left = 0;
+    int right = 0;
+    for (unsigned int itx = 0; itx < 4; itx ++)
+    {
+        int channel_output = this->channels[itx]->get_output();
+        if (panning & (0x10 << itx))
+            left += channel_output;
+        if (panning & (0x01 << itx))
+            right += channel_output;
+    }
+
+    // NR50 master volume, 0-7 for each side
+    uint8_t master_volume = this->registers[this->NR50_ADDR - this->NR10_ADDR];
+    left *= (((master_volume >> 4) & 0x07) + 1) * this->MIX_SCALE;
+    right *= ((master_volume & 0x07) + 1) * this->MIX_SCALE;
+
+    if (left == this->level_left && right == this->level_right)
+        return;
+    this->level_left = (int16_t)left;
+    this->level_right = (int16_t)right;
+    this->output->set_level(cycle, this->level_left, this->level_right);
+}
+
+void Apu::frame_sequencer_event()
+{
+    uint64_t cycle = this->next_frame_sequencer_cycle;
+    this->run_until(cycle);
+
+    if (this->powered)
+    {
+        // Length on even steps, sweep on steps 2 and 6, envelope on step 7
+        if ((this->frame_sequencer_step & 1) == 0)
+            for (auto channel : this->channels)
+                channel->clock_length();
+        if (this->frame_sequencer_step == 2 || this->frame_sequencer_step == 6)
+            this->square1.clock_sweep();
+        if (this->frame_sequencer_step == 7)
+        {
+            this->square1.clock_envelope();
+            this->square2.clock_envelope();
+            this->noise.clock_envelope();
+        }
+        this->frame_sequencer_step = (this->frame_sequencer_step + 1) & 0x07;
+        this->update_level(cycle);
+    }
+
+    this->next_frame_sequencer_cycle += this->FRAME_SEQUENCER_PERIOD;
+    this->scheduler->schedule(SchedulerEvent::EVENT_APU, this->next_frame_sequencer_cycle);
+}
+
+void Apu::power_off()
+{
+    for (auto channel : this->channels)
+        channel->reset();
+    memset(this->registers, 0, sizeof(this->registers));
+    this->powered = false;
+}
+
+uint8_t Apu::io_read(uint16_t address, uint8_t stored_val)
+{
+    if (address >= this->WAVE_RAM_ADDR)
+        return this->wave.read_wave(address - this->WAVE_RAM_ADDR);
+
+    if (address == this->NR52_ADDR)
+    {
+        // Channel status bits are read-only
+        uint8_t status = this->READ_MASKS[address - this->NR10_ADDR];
+        if (this->powered)
+            status |= this->NR52_POWER;
+        for (unsigned int itx = 0; itx < 4; itx ++)
+            if (this->channels[itx]->is_enabled())
+                status |= (uint8_t)(1 << itx);
+        return status;
+    }
+
+    return this->registers[address - this->NR10_ADDR] | this->READ_MASKS[address - this->NR10_ADDR];
+}
+
+void Apu::io_write(uint16_t address, uint8_t val)
+{
+    uint64_t cycle = this->scheduler->get_cycle();
+    // Changes apply from now, so catch up with the previous state
+    this->run_until(cycle);
+
+    if (address >= this->WAVE_RAM_ADDR)
+    {
+        this->wave.write_wave(address - this->WAVE_RAM_ADDR, val);
+        this->update_level(cycle);
+        return;
+    }
+
+    if (address == this->NR52_ADDR)
+    {
+        if (! (val & this->NR52_POWER) && this->powered)
+        {
+            this->power_off();
+        }
+        else if ((val & this->NR52_POWER) && ! this->powered)
+        {
+            this->powered = true;
+            this->frame_sequencer_step = 0;
+        }
+        this->update_level(cycle);
+        return;
+    }
+
+    // Registers cannot be written whilst powered off
+    if (! this->powered)
+        return;
+    this->registers[address - this->NR10_ADDR] = val;
+
+    // Channel registers, 5 per channel
+    if (address < this->NR50_ADDR)
+    {
+        unsigned int offset = address - this->NR10_ADDR;
+        this->channels[offset / 5]->write(offset % 5, val, cycle);
+    }
+    this->update_level(cycle);
+}
@@ -0,0 +1,98 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+#pragma once
+
+#include <memory>
+#include "ram.h"
+#include "io_handler.h"
+#include "scheduler.h"
+#include "apu_channel.h"
+#include "apu_output.h"
+
+// Saved registers, frame sequencer and channel state
+struct apu_state_t {
+    uint8_t registers[0x20];
+    bool powered;
+    unsigned int frame_sequencer_step;
+    uint64_t next_frame_sequencer_cycle;
+    int16_t level_left;
+    int16_t level_right;
+    apu_channel_state_t channels[4];
+};
+
+// Audio processing unit - sound registers (0xff10-0xff3f), the frame
+// sequencer and mixing of the 4 channels.
+// Channels are only stepped at their period boundaries, and only when
+// an output is set, catching up whenever a register is accessed or the
+// frame sequencer is clocked. Mixed levels are passed to the output
+// whenever they change.
+class Apu : public IoHandler {
+public:
+    Apu(RAM *ram, Scheduler *scheduler);
+
+    // Set output for mixed levels. Without one, registers and
+    // channel state are emulated, but no waveforms are generated.
+    void set_output(ApuOutput *output);
+
+    uint8_t io_read(uint16_t address, uint8_t stored_val);
+    void io_write(uint16_t address, uint8_t val);
+
+    // Frame sequencer step (512Hz) is due
+    void frame_sequencer_event();
+
+    void save_state(apu_state_t &state);
+    // Scheduler state must already be restored
+    void load_state(const apu_state_t &state);
+
+private:
+    const uint16_t NR10_ADDR = 0xff10;
+    const uint16_t NR50_ADDR = 0xff24;
+    const uint16_t NR51_ADDR = 0xff25;
+    const uint16_t NR52_ADDR = 0xff26;
+    const uint16_t WAVE_RAM_ADDR = 0xff30;
+    const uint16_t REGISTER_END_ADDR = 0xff3f;
+    const uint8_t NR52_POWER = 0x80;
+    // Unused and write-only bits, which read as 1, for 0xff10-0xff2f
+    const uint8_t READ_MASKS[0x20] = {
+        0x80, 0x3f, 0x00, 0xff, 0xbf,
+        0xff, 0x3f, 0x00, 0xff, 0xbf,
+        0x7f, 0xff, 0x9f, 0xff, 0xbf,
+        0xff, 0xff, 0x00, 0x00, 0xbf,
+        0x00, 0x00, 0x70,
+        0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff
+    };
+    const uint64_t FRAME_SEQUENCER_PERIOD = 8192;
+    // Scale of mixed output, with all 4 channels at full
+    // volume (4 * 15 * 8) giving +-15360
+    const int MIX_SCALE = 32;
+
+    Scheduler *scheduler;
+    ApuOutput *output;
+
+    SquareChannel square1;
+    SquareChannel square2;
+    WaveChannel wave;
+    NoiseChannel noise;
+    ApuChannel *channels[4];
+
+    // Written values of 0xff10-0xff2f
+    uint8_t registers[0x20];
+    bool powered;
+    unsigned int frame_sequencer_step;
+    uint64_t next_frame_sequencer_cycle;
+
+    int16_t level_left;
+    int16_t level_right;
+
+    // Step channels up to the cycle, passing level changes to the output
+    void run_until(uint64_t cycle);
+    // Recalculate mixed level, passing it to output if changed
+    void update_level(uint64_t cycle);
+    // Continue output from the current cycle, after it has been
+    // set or state has been loaded
+    void sync_output();
+    void power_off();
+};
@@ -0,0 +1,448 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+#include "apu_channel.h"
+
+#include <string.h>
+
+ApuChannel::ApuChannel(unsigned int length_max)
+{
+    this->length_max = length_max;
+    this->reset();
+}
+
+void ApuChannel::reset()
+{
+    this->enabled = false;
+    this->dac_enabled = false;
+    this->length_counter = 0;
+    this->length_enabled = false;
+    this->next_step_cycle = UINT64_MAX;
+    this->volume = 0;
+    this->envelope_initial = 0;
+    this->envelope_increase = false;
+    this->envelope_period = 0;
+    this->envelope_timer = 0;
+}
+
+void ApuChannel::step()
+{
+    this->advance();
+    this->next_step_cycle += this->get_period();
+}
+
+void ApuChannel::resync(uint64_t cycle)
+{
+    if (this->next_step_cycle < cycle)
+        this->next_step_cycle = cycle + this->get_period();
+}
+
+void ApuChannel::disable()
+{
+    this->enabled = false;
+    this->next_step_cycle = UINT64_MAX;
+}
+
+void ApuChannel::trigger(uint64_t cycle)
+{
+    if (this->length_counter == 0)
+        this->length_counter = this->length_max;
+    this->volume = this->envelope_initial;
+    this->envelope_timer = this->envelope_period;
+
+    // Channel only starts if its DAC is on
+    this->enabled = this->dac_enabled;
+    this->next_step_cycle = this->enabled ? cycle + this->get_period() : UINT64_MAX;
+}
+
+void ApuChannel::write_length(unsigned int length)
+{
+    this->length_counter = this->length_max - length;
+}
+
+void ApuChannel::write_envelope(uint8_t val)
+{
+    this->envelope_initial = val >> 4;
+    this->envelope_increase = (val & 0x08) != 0;
+    this->envelope_period = val & 0x07;
+
+    // DAC is off when initial volume is 0 and decreasing
+    this->dac_enabled = (val & 0xf8) != 0;
+    if (! this->dac_enabled)
+        this->disable();
+}
+
+void ApuChannel::write_control(uint8_t val, uint64_t cycle)
+{
+    this->length_enabled = (val & 0x40) != 0;
+    if (val & 0x80)
+        this->trigger(cycle);
+}
+
+void ApuChannel::clock_length()
+{
+    if (! this->length_enabled || this->length_counter == 0)
+        return;
+    if (-- this->length_counter == 0)
+        this->disable();
+}
+
+void ApuChannel::clock_envelope()
+{
+    if (this->envelope_period == 0)
+        return;
+    if (this->envelope_timer > 0)
+        this->envelope_timer --;
+    if (this->envelope_timer != 0)
+        return;
+
+    this->envelope_timer = this->envelope_period;
+    if (this->envelope_increase && this->volume < 0x0f)
+        this->volume ++;
+    else if (! this->envelope_increase && this->volume > 0)
+        this->volume --;
+}
+
+
+SquareChannel::SquareChannel(bool has_sweep) : ApuChannel(64)
+{
+    this->has_sweep = has_sweep;
+    this->reset();
+}
+
+void ApuChannel::save_state(apu_channel_state_t &state)
+{
+    memset(&state, 0, sizeof(state));
+    state.enabled = this->enabled;
+    state.dac_enabled = this->dac_enabled;
+    state.length_counter = this->length_counter;
+    state.length_enabled = this->length_enabled;
+    state.next_step_cycle = this->next_step_cycle;
+    state.volume = this->volume;
+    state.envelope_initial = this->envelope_initial;
+    state.envelope_increase = this->envelope_increase;
+    state.envelope_period = this->envelope_period;
+    state.envelope_timer = this->envelope_timer;
+}
+
+void ApuChannel::load_state(const apu_channel_state_t &state)
+{
+    this->enabled = state.enabled;
+    this->dac_enabled = state.dac_enabled;
+    this->length_counter = state.length_counter;
+    this->length_enabled = state.length_enabled;
+    this->next_step_cycle = state.next_step_cycle;
+    this->volume = state.volume;
+    this->envelope_initial = state.envelope_initial;
+    this->envelope_increase = state.envelope_increase;
+    this->envelope_period = state.envelope_period;
+    this->envelope_timer = state.envelope_timer;
+}
+
+void SquareChannel::reset()
+{
+    ApuChannel::reset();
+    this->duty = 0;
+    this->duty_position = 0;
+    this->frequency = 0;
+    this->sweep_period = 0;
+    this->sweep_negate = false;
+    this->sweep_shift = 0;
+    this->sweep_timer = 0;
+    this->sweep_enabled = false;
+    this->sweep_shadow = 0;
+}
+
+void SquareChannel::write(unsigned int reg, uint8_t val, uint64_t cycle)
+{
+    switch (reg)
+    {
+        case 0:
+            if (! this->has_sweep)
+                break;
+            this->sweep_period = (val >> 4) & 0x07;
+            this->sweep_negate = (val & 0x08) != 0;
+            this->sweep_shift = val & 0x07;
+            break;
+        case 1:
+            this->duty = val >> 6;
+            this->write_length(val & 0x3f);
+            break;
+        case 2:
+            this->write_envelope(val);
+            break;
+        case 3:
+            this->frequency = (this->frequency & 0x700) | val;
+            break;
+        case 4:
+            this->frequency = (this->frequency & 0x0ff) | ((uint16_t)(val & 0x07) << 8);
+            this->write_control(val, cycle);
+            break;
+    }
+}
+
+uint64_t SquareChannel::get_period()
+{
+    return (2048 - this->frequency) * 4;
+}
+
+void SquareChannel::advance()
+{
+    this->duty_position = (this->duty_position + 1) & 0x07;
+}
+
+uint8_t SquareChannel::get_output()
+{
+    if (! this->enabled)
+        return 0;
+    return ((this->DUTY_PATTERNS[this->duty] >> (7 - this->duty_position)) & 0x01) * this->volume;
+}
+
+void SquareChannel::trigger(uint64_t cycle)
+{
+    ApuChannel::trigger(cycle);
+    if (! this->has_sweep)
+        return;
+
+    this->sweep_shadow = this->frequency;
+    this->sweep_timer = this->sweep_period ? this->sweep_period : 8;
+    this->sweep_enabled = this->sweep_period != 0 || this->sweep_shift != 0;
+    // Overflow is checked immediately
+    if (this->sweep_shift != 0)
+        this->calculate_sweep();
+}
+
+uint16_t SquareChannel::calculate_sweep()
+{
+    uint16_t delta = this->sweep_shadow >> this->sweep_shift;
+    uint16_t new_frequency = this->sweep_negate ? this->sweep_shadow - delta : this->sweep_shadow + delta;
+    if (new_frequency > this->MAX_FREQUENCY)
+        this->disable();
+    return new_frequency;
+}
+
+void SquareChannel::clock_sweep()
+{
+    if (this->sweep_timer > 0)
+        this->sweep_timer --;
+    if (this->sweep_timer != 0)
+        return;
+
+    // A period of 0 is treated as 8, but does not sweep
+    this->sweep_timer = this->sweep_period ? this->sweep_period : 8;
+    if (! this->sweep_enabled || this->sweep_period == 0)
+        return;
+
+    uint16_t new_frequency = this->calculate_sweep();
+    if (new_frequency <= this->MAX_FREQUENCY && this->sweep_shift != 0)
+    {
+        this->frequency = new_frequency;
+        this->sweep_shadow = new_frequency;
+        // New frequency is checked for overflow again
+        this->calculate_sweep();
+    }
+}
+
+
+WaveChannel::WaveChannel() : ApuChannel(256)
+{
+    // Wave RAM is not cleared on power off
+    memset(this->wave_ram, 0, sizeof(this->wave_ram));
+    this->reset();
+}
+
+void SquareChannel::save_state(apu_channel_state_t &state)
+{
+    ApuChannel::save_state(state);
+    state.frequency = this->frequency;
+    state.duty = this->duty;
+    state.duty_position = this->duty_position;
+    state.sweep_period = this->sweep_period;
+    state.sweep_negate = this->sweep_negate;
+    state.sweep_shift = this->sweep_shift;
+    state.sweep_timer = this->sweep_timer;
+    state.sweep_enabled = this->sweep_enabled;
+    state.sweep_shadow = this->sweep_shadow;
+}
+
+void SquareChannel::load_state(const apu_channel_state_t &state)
+{
+    ApuChannel::load_state(state);
+    this->frequency = state.frequency;
+    this->duty = state.duty;
+    this->duty_position = state.duty_position;
+    this->sweep_period = state.sweep_period;
+    this->sweep_negate = state.sweep_negate;
+    this->sweep_shift = state.sweep_shift;
+    this->sweep_timer = state.sweep_timer;
+    this->sweep_enabled = state.sweep_enabled;
+    this->sweep_shadow = state.sweep_shadow;
+}
+
+void WaveChannel::reset()
+{
+    ApuChannel::reset();
+    this->volume_code = 0;
+    this->position = 0;
+    this->frequency = 0;
+}
+
+void WaveChannel::write(unsigned int reg, uint8_t val, uint64_t cycle)
+{
+    switch (reg)
+    {
+        case 0:
+            this->dac_enabled = (val & 0x80) != 0;
+            if (! this->dac_enabled)
+                this->disable();
+            break;
+        case 1:
+            this->write_length(val);
+            break;
+        case 2:
+            this->volume_code = (val >> 5) & 0x03;
+            break;
+        case 3:
+            this->frequency = (this->frequency & 0x700) | val;
+            break;
+        case 4:
+            this->frequency = (this->frequency & 0x0ff) | ((uint16_t)(val & 0x07) << 8);
+            this->write_control(val, cycle);
+            break;
+    }
+}
+
+uint64_t WaveChannel::get_period()
+{
+    return (2048 - this->frequency) * 2;
+}
+
+void WaveChannel::advance()
+{
+    this->position = (this->position + 1) & 0x1f;
+}
+
+uint8_t WaveChannel::get_output()
+{
+    if (! this->enabled)
+        return 0;
+    // Two samples per byte, high nibble first
+    uint8_t sample = (this->wave_ram[this->position >> 1] >> ((this->position & 1) ? 0 : 4)) & 0x0f;
+    return sample >> this->VOLUME_SHIFTS[this->volume_code];
+}
+
+void WaveChannel::trigger(uint64_t cycle)
+{
+    ApuChannel::trigger(cycle);
+    this->position = 0;
+}
+
+uint8_t WaveChannel::read_wave(unsigned int index)
+{
+    return this->wave_ram[index];
+}
+
+void WaveChannel::write_wave(unsigned int index, uint8_t val)
+{
+    this->wave_ram[index] = val;
+}
+
+
+NoiseChannel::NoiseChannel() : ApuChannel(64)
+{
+    this->reset();
+}
+
+void WaveChannel::save_state(apu_channel_state_t &state)
+{
+    ApuChannel::save_state(state);
+    state.frequency = this->frequency;
+    memcpy(state.wave_ram, this->wave_ram, sizeof(state.wave_ram));
+    state.volume_code = this->volume_code;
+    state.position = this->position;
+}
+
+void WaveChannel::load_state(const apu_channel_state_t &state)
+{
+    ApuChannel::load_state(state);
+    this->frequency = state.frequency;
+    memcpy(this->wave_ram, state.wave_ram, sizeof(this->wave_ram));
+    this->volume_code = state.volume_code;
+    this->position = state.position;
+}
+
+void NoiseChannel::reset()
+{
+    ApuChannel::reset();
+    this->lfsr = 0x7fff;
+    this->clock_shift = 0;
+    this->width_7bit = false;
+    this->divisor_code = 0;
+}
+
+void NoiseChannel::write(unsigned int reg, uint8_t val, uint64_t cycle)
+{
+    switch (reg)
+    {
+        case 1:
+            this->write_length(val & 0x3f);
+            break;
+        case 2:
+            this->write_envelope(val);
+            break;
+        case 3:
+            this->clock_shift = val >> 4;
+            this->width_7bit = (val & 0x08) != 0;
+            this->divisor_code = val & 0x07;
+            break;
+        case 4:
+            this->write_control(val, cycle);
+            break;
+    }
+}
+
+uint64_t NoiseChannel::get_period()
+{
+    return this->DIVISORS[this->divisor_code] << this->clock_shift;
+}
+
+void NoiseChannel::advance()
+{
+    uint16_t feedback = (this->lfsr ^ (this->lfsr >> 1)) & 0x01;
+    this->lfsr = (this->lfsr >> 1) | (feedback << 14);
+    if (this->width_7bit)
+        this->lfsr = (this->lfsr & ~0x40) | (feedback << 6);
+}
+
+uint8_t NoiseChannel::get_output()
+{
+    if (! this->enabled)
+        return 0;
+    return (this->lfsr & 0x01) ? 0 : this->volume;
+}
+
+void NoiseChannel::trigger(uint64_t cycle)
+{
+    ApuChannel::trigger(cycle);
+    this->lfsr = 0x7fff;
+}
+
+void NoiseChannel::save_state(apu_channel_state_t &state)
+{
+    ApuChannel::save_state(state);
+    state.lfsr = this->lfsr;
+    state.clock_shift = this->clock_shift;
+    state.width_7bit = this->width_7bit;
+    state.divisor_code = this->divisor_code;
+}
+
+void NoiseChannel::load_state(const apu_channel_state_t &state)
+{
+    ApuChannel::load_state(state);
+    this->lfsr = state.lfsr;
+    this->clock_shift = state.clock_shift;
+    this->width_7bit = state.width_7bit;
+    this->divisor_code = state.divisor_code;
+}
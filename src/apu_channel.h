@@ -0,0 +1,208 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+#pragma once
+
+#include <memory>
+#include <cstdint>
+
+// Saved channel state, with the fields of every channel type,
+// of which each channel only uses its own
+struct apu_channel_state_t {
+    bool enabled;
+    bool dac_enabled;
+    unsigned int length_counter;
+    bool length_enabled;
+    uint64_t next_step_cycle;
+    uint8_t volume;
+    uint8_t envelope_initial;
+    bool envelope_increase;
+    uint8_t envelope_period;
+    uint8_t envelope_timer;
+    uint16_t frequency;
+
+    // Square
+    uint8_t duty;
+    uint8_t duty_position;
+    uint8_t sweep_period;
+    bool sweep_negate;
+    uint8_t sweep_shift;
+    uint8_t sweep_timer;
+    bool sweep_enabled;
+    uint16_t sweep_shadow;
+
+    // Wave
+    uint8_t wave_ram[16];
+    uint8_t volume_code;
+    uint8_t position;
+
+    // Noise
+    uint16_t lfsr;
+    uint8_t clock_shift;
+    bool width_7bit;
+    uint8_t divisor_code;
+};
+
+// Sound channel, with the length counter, volume envelope and period
+// timer common to all channels. Rather than being clocked every cycle,
+// each channel reports the cycle of its next period step, and its
+// output only changes at those steps, register writes and frame
+// sequencer clocks.
+class ApuChannel {
+public:
+    ApuChannel(unsigned int length_max);
+    virtual ~ApuChannel() {};
+
+    // Write to channel register (0-4, for NRx0-NRx4), at the given cycle
+    virtual void write(unsigned int reg, uint8_t val, uint64_t cycle) = 0;
+    // Current digital output (0-15)
+    virtual uint8_t get_output() = 0;
+    // Power off, clearing all registers
+    virtual void reset();
+
+    // Perform period step, due at get_next_step_cycle()
+    void step();
+    // Restart period from the cycle, if the next step is already overdue
+    void resync(uint64_t cycle);
+    // Cycle of next period step, UINT64_MAX whilst disabled
+    uint64_t get_next_step_cycle() {
+        return this->next_step_cycle;
+    };
+    bool is_enabled() {
+        return this->enabled;
+    };
+    bool is_dac_enabled() {
+        return this->dac_enabled;
+    };
+
+    // Frame sequencer clocks
+    void clock_length();
+    void clock_envelope();
+
+    virtual void save_state(apu_channel_state_t &state);
+    virtual void load_state(const apu_channel_state_t &state);
+
+protected:
+    unsigned int length_max;
+    bool enabled;
+    bool dac_enabled;
+    unsigned int length_counter;
+    bool length_enabled;
+    uint64_t next_step_cycle;
+
+    // Volume, set from the envelope on trigger
+    uint8_t volume;
+    uint8_t envelope_initial;
+    bool envelope_increase;
+    uint8_t envelope_period;
+    uint8_t envelope_timer;
+
+    // Advance waveform by one step
+    virtual void advance() = 0;
+    // Cycles between steps
+    virtual uint64_t get_period() = 0;
+    virtual void trigger(uint64_t cycle);
+    void disable();
+
+    // NRx1 length (and the length load)
+    void write_length(unsigned int length);
+    // NRx2 envelope, which also powers the DAC
+    void write_envelope(uint8_t val);
+    // NRx4 length enable and trigger
+    void write_control(uint8_t val, uint64_t cycle);
+};
+
+// Square wave channels 1 (with frequency sweep) and 2
+class SquareChannel : public ApuChannel {
+public:
+    SquareChannel(bool has_sweep);
+
+    void write(unsigned int reg, uint8_t val, uint64_t cycle);
+    uint8_t get_output();
+    void reset();
+    void save_state(apu_channel_state_t &state);
+    void load_state(const apu_channel_state_t &state);
+
+    void clock_sweep();
+
+protected:
+    void advance();
+    uint64_t get_period();
+    void trigger(uint64_t cycle);
+
+private:
+    // Waveform for 12.5%, 25%, 50% and 75% duty, one bit per step
+    const uint8_t DUTY_PATTERNS[4] = {0x01, 0x81, 0x87, 0x7e};
+    const uint16_t MAX_FREQUENCY = 0x7ff;
+
+    bool has_sweep;
+    uint8_t duty;
+    uint8_t duty_position;
+    uint16_t frequency;
+
+    uint8_t sweep_period;
+    bool sweep_negate;
+    uint8_t sweep_shift;
+    uint8_t sweep_timer;
+    bool sweep_enabled;
+    uint16_t sweep_shadow;
+
+    // Next swept frequency, disabling the channel on overflow
+    uint16_t calculate_sweep();
+};
+
+// Wave channel 3, playing 32 4-bit samples from wave RAM
+class WaveChannel : public ApuChannel {
+public:
+    WaveChannel();
+
+    void write(unsigned int reg, uint8_t val, uint64_t cycle);
+    uint8_t get_output();
+    void reset();
+    void save_state(apu_channel_state_t &state);
+    void load_state(const apu_channel_state_t &state);
+
+    uint8_t read_wave(unsigned int index);
+    void write_wave(unsigned int index, uint8_t val);
+
+protected:
+    void advance();
+    uint64_t get_period();
+    void trigger(uint64_t cycle);
+
+private:
+    // Right shift of samples for each volume code (mute, 100%, 50%, 25%)
+    const uint8_t VOLUME_SHIFTS[4] = {4, 0, 1, 2};
+
+    uint8_t wave_ram[16];
+    uint8_t volume_code;
+    uint8_t position;
+    uint16_t frequency;
+};
+
+// Noise channel 4, from a linear feedback shift register
+class NoiseChannel : public ApuChannel {
+public:
+    NoiseChannel();
+
+    void write(unsigned int reg, uint8_t val, uint64_t cycle);
+    uint8_t get_output();
+    void reset();
+    void save_state(apu_channel_state_t &state);
+    void load_state(const apu_channel_state_t &state);
+
+protected:
+    void advance();
+    uint64_t get_period();
+    void trigger(uint64_t cycle);
+
+private:
+    const uint64_t DIVISORS[8] = {8, 16, 32, 48, 64, 80, 96, 112};
+
+    uint16_t lfsr;
+    uint8_t clock_shift;
+    bool width_7bit;
+    uint8_t divisor_code;
+};
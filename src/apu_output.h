@@ -0,0 +1,26 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+#pragma once
+
+#include <memory>
+#include <cstdint>
+
+// Converts the APU's mixed output, which only changes at channel
+// period boundaries and register writes, into host-rate samples.
+// Cycles passed are always increasing, other than through set_cycle.
+class ApuOutput {
+public:
+    virtual ~ApuOutput() {};
+
+    // Mixed output level has changed, at the given cycle
+    virtual void set_level(uint64_t cycle, int16_t left, int16_t right) = 0;
+    // All level changes up to the cycle have been given, so
+    // samples can be produced up to it
+    virtual void run_until(uint64_t cycle) = 0;
+    // Emulated time has jumped (e.g. a saved state was loaded), so
+    // continue output from the given cycle, without a gap
+    virtual void set_cycle(uint64_t cycle) = 0;
+};
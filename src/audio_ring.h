@@ -0,0 +1,28 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+#pragma once
+
+#include <memory>
+#include <cstdint>
+
+#include "spsc_queue.h"
+
+// Number of stereo frames buffered between the APU and the audio
+// consumer (~186ms at 44.1kHz)
+#define AUDIO_RING_FRAMES 8192
+
+// Default host sample rate
+#define AUDIO_SAMPLE_RATE 44100
+
+// Single stereo sample
+struct audio_frame_t {
+    int16_t left;
+    int16_t right;
+};
+
+// Samples produced by the emulation thread and consumed by the
+// audio device callback or an audio writer thread
+typedef SpscQueue<audio_frame_t, AUDIO_RING_FRAMES> AudioRing;
@@ -0,0 +1,127 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+#include "audio_writer.h"
+
+#include <iostream>
+#include <chrono>
+#include <string.h>
+
+// Time writer thread waits, when there are no samples queued
+#define AUDIO_WRITER_WAIT_MS 1
+
+AudioWriter::AudioWriter(AudioRing *ring)
+{
+    this->ring = ring;
+    this->output = nullptr;
+    this->started = false;
+    this->sample_rate = 0;
+    this->stop_requested = false;
+    this->frames_written = 0;
+    this->write_failed = false;
+}
+
+AudioWriter::~AudioWriter()
+{
+    this->finish();
+}
+
+bool AudioWriter::start(const char *path, unsigned int sample_rate)
+{
+    this->sample_rate = sample_rate;
+    if (strcmp(path, "null") != 0)
+    {
+        this->output = fopen(path, "wb");
+        if (this->output == nullptr)
+        {
+            std::cout << "Unable to open audio output: " << path << std::endl;
+            return false;
+        }
+        // Sizes are filled in once all samples are written
+        if (! this->write_wav_header(0))
+            this->write_failed = true;
+    }
+
+    this->started = true;
+    this->writer_thread = std::thread(&AudioWriter::run, this);
+    return true;
+}
+
+bool AudioWriter::write_wav_header(uint64_t frame_count)
+{
+    uint32_t data_size = (uint32_t)(frame_count * sizeof(audio_frame_t));
+    uint32_t riff_size = data_size + (uint32_t)this->WAV_HEADER_SIZE - 8;
+    uint32_t fmt_size = 16;
+    uint16_t format_pcm = 1;
+    uint16_t channels = 2;
+    uint32_t byte_rate = this->sample_rate * sizeof(audio_frame_t);
+    uint16_t block_align = sizeof(audio_frame_t);
+    uint16_t bits_per_sample = 16;
+
+    // Fields are little endian, as is the host
+    uint8_t header[44];
+    memcpy(&header[0], "RIFF", 4);
+    memcpy(&header[4], &riff_size, 4);
+    memcpy(&header[8], "WAVEfmt ", 8);
+    memcpy(&header[16], &fmt_size, 4);
+    memcpy(&header[20], &format_pcm, 2);
+    memcpy(&header[22], &channels, 2);
+    memcpy(&header[24], &this->sample_rate, 4);
+    memcpy(&header[28], &byte_rate, 4);
+    memcpy(&header[32], &block_align, 2);
+    memcpy(&header[34], &bits_per_sample, 2);
+    memcpy(&header[36], "data", 4);
+    memcpy(&header[40], &data_size, 4);
+
+    return fseek(this->output, 0, SEEK_SET) == 0 &&
+           fwrite(header, sizeof(header), 1, this->output) == 1;
+}
+
+void AudioWriter::finish()
+{
+    if (! this->started)
+        return;
+    this->started = false;
+
+    this->stop_requested = true;
+    this->writer_thread.join();
+
+    if (this->output != nullptr)
+    {
+        if (! this->write_wav_header(this->frames_written))
+            this->write_failed = true;
+        if (fclose(this->output) != 0)
+            this->write_failed = true;
+        this->output = nullptr;
+    }
+
+    std::cout << "Audio output: " << std::dec << this->frames_written << " samples written" << std::endl;
+    if (this->write_failed)
+        std::cout << "Audio output failed to write to file" << std::endl;
+}
+
+void AudioWriter::run()
+{
+    while (true)
+    {
+        unsigned int chunk_frames = 0;
+        while (chunk_frames < AUDIO_WRITER_CHUNK_FRAMES && this->ring->pop(this->chunk[chunk_frames]))
+            chunk_frames ++;
+
+        if (chunk_frames == 0)
+        {
+            // Stop once all samples have been written
+            if (this->stop_requested)
+                return;
+            std::this_thread::sleep_for(std::chrono::milliseconds(AUDIO_WRITER_WAIT_MS));
+            continue;
+        }
+
+        if (this->output != nullptr && ! this->write_failed &&
+            fwrite(this->chunk, sizeof(audio_frame_t), chunk_frames, this->output) != chunk_frames)
+            this->write_failed = true;
+        this->frames_written += chunk_frames;
+    }
+}
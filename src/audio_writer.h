@@ -0,0 +1,49 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+#pragma once
+
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <stdio.h>
+
+#include "audio_ring.h"
+
+// Number of frames written to file at once
+#define AUDIO_WRITER_CHUNK_FRAMES 1024
+
+// Consumes samples from the audio ring on a writer thread, for runs
+// without an audio device. Samples are either written to a 16-bit
+// stereo WAV file or, for the 'null' path, discarded.
+class AudioWriter {
+public:
+    AudioWriter(AudioRing *ring);
+    ~AudioWriter();
+
+    bool start(const char *path, unsigned int sample_rate);
+    // Write remaining samples and close the output
+    void finish();
+
+private:
+    // Size of RIFF/WAVE header, before sample data
+    const long WAV_HEADER_SIZE = 44;
+
+    AudioRing *ring;
+    FILE *output;
+    bool started;
+    unsigned int sample_rate;
+
+    std::thread writer_thread;
+    std::atomic<bool> stop_requested;
+    uint64_t frames_written;
+    bool write_failed;
+
+    audio_frame_t chunk[AUDIO_WRITER_CHUNK_FRAMES];
+
+    void run();
+    // Write header, with sizes for the given number of frames
+    bool write_wav_header(uint64_t frame_count);
+};
@@ -0,0 +1,193 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+#include "batch_runner.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <chrono>
+#include <string.h>
+
+#include "work_stealing_pool.h"
+#include "gameboy.h"
+
+BatchRunner::BatchRunner(const char *bios_path, uint64_t default_max_ticks)
+{
+    this->bios_path = bios_path;
+    this->default_max_ticks = default_max_ticks;
+}
+
+bool BatchRunner::load(const char *manifest_path)
+{
+    std::ifstream manifest(manifest_path);
+    if (! manifest.is_open())
+    {
+        std::cout << "Unable to open batch manifest: " << manifest_path << std::endl;
+        return false;
+    }
+
+    std::string line;
+    unsigned int line_number = 0;
+    while (std::getline(manifest, line))
+    {
+        line_number ++;
+        std::istringstream tokens(line);
+        batch_job_t job;
+        // Skip blank lines and comments
+        if (! (tokens >> job.rom_path) || job.rom_path[0] == '#')
+            continue;
+
+        job.max_ticks = this->default_max_ticks;
+        job.status = BatchStatus::BATCH_ERROR;
+        job.frames = 0;
+        job.cycles = 0;
+        job.memory_hash = 0;
+        job.host_ms = 0;
+
+        std::string option;
+        while (tokens >> option)
+        {
+            size_t separator = option.find('=');
+            std::string name = option.substr(0, separator);
+            std::string value = separator == std::string::npos ? "" : option.substr(separator + 1);
+            if (name == "ticks" && ! value.empty())
+                job.max_ticks = strtoull(value.c_str(), nullptr, 10);
+            else if (name == "pass" && ! value.empty())
+                job.pass_patterns.push_back(value);
+            else if (name == "fail" && ! value.empty())
+                job.fail_patterns.push_back(value);
+            else if (name == "hash" && ! value.empty())
+                job.expected_hashes.push_back(value);
+            else if (name == "state" && ! value.empty())
+                job.state_path = value;
+            else
+            {
+                std::cout << manifest_path << ":" << std::dec << line_number << ": Invalid option: " << option << std::endl;
+                return false;
+            }
+        }
+        this->jobs.push_back(job);
+    }
+    return true;
+}
+
+bool BatchRunner::run(unsigned int thread_count)
+{
+    WorkStealingPool pool(thread_count);
+    for (unsigned int itx = 0; itx < this->jobs.size(); itx ++)
+        pool.add(std::bind(&BatchRunner::run_job, this, &this->jobs[itx]));
+
+    std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+    pool.run();
+    double total_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+
+    // Results are printed in manifest order, once all have completed,
+    // so that they are not interleaved with output from instances
+    unsigned int passed = 0;
+    std::ostringstream results;
+    results << std::fixed << std::setprecision(1);
+    for (unsigned int itx = 0; itx < this->jobs.size(); itx ++)
+    {
+        batch_job_t *job = &this->jobs[itx];
+        if (job->status == BatchStatus::BATCH_PASSED)
+            passed ++;
+        results << (job->status == BatchStatus::BATCH_PASSED ? "PASS" : job->status == BatchStatus::BATCH_FAILED ? "FAIL" : "ERROR") <<
+            " " << job->rom_path << ": " << job->reason <<
+            " (frames " << job->frames << ", cycles " << job->cycles <<
+            ", memory " << std::hex << std::setfill('0') << std::setw(16) << job->memory_hash << std::dec << std::setfill(' ') <<
+            ", " << job->host_ms << "ms)" << std::endl;
+    }
+    results << "Batch: " << passed << "/" << this->jobs.size() << " passed in " << total_ms << "ms" << std::endl;
+    std::cout << results.str() << std::flush;
+
+    return passed == this->jobs.size();
+}
+
+void BatchRunner::run_job(batch_job_t *job)
+{
+    std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+
+    // Each instance is independent of all others, and
+    // has no display or audio output
+    std::unique_ptr<GameBoy> gameboy(new GameBoy());
+
+    SerialBufferSink serial_buffer;
+    for (unsigned int itx = 0; itx < job->pass_patterns.size(); itx ++)
+        serial_buffer.add_pattern(job->pass_patterns[itx].c_str(), SerialResult::SERIAL_PASSED);
+    for (unsigned int itx = 0; itx < job->fail_patterns.size(); itx ++)
+        serial_buffer.add_pattern(job->fail_patterns[itx].c_str(), SerialResult::SERIAL_FAILED);
+    gameboy->set_serial_result(&serial_buffer);
+
+    FrameHasher frame_hasher;
+    for (unsigned int itx = 0; itx < job->expected_hashes.size(); itx ++)
+    {
+        if (! frame_hasher.add_expected(job->expected_hashes[itx].c_str()))
+        {
+            job->reason = "invalid expected hash " + job->expected_hashes[itx];
+            return;
+        }
+    }
+    // Frames are only drawn when they are to be hashed
+    if (job->expected_hashes.empty())
+        gameboy->get_vpu()->frame_skip.set_target_cycle(job->max_ticks);
+    else
+        gameboy->set_frame_hasher(&frame_hasher);
+
+    if (! gameboy->load(this->bios_path.c_str(), job->rom_path.c_str()))
+    {
+        job->reason = "unable to open BIOS or ROM";
+        return;
+    }
+    if (! job->state_path.empty() && ! gameboy->load_state_file(job->state_path.c_str()))
+    {
+        job->reason = "unable to load save state";
+        return;
+    }
+    gameboy->set_stop_cycle(job->max_ticks, nullptr);
+
+    while (gameboy->run_frame())
+        ;
+    frame_hasher.finish();
+    gameboy->get_vpu()->screenshots.finish();
+
+    bool has_conditions = ! (job->pass_patterns.empty() && job->fail_patterns.empty() && job->expected_hashes.empty());
+    if (serial_buffer.get_result() == SerialResult::SERIAL_FAILED)
+    {
+        job->status = BatchStatus::BATCH_FAILED;
+        job->reason = "serial output failed";
+    }
+    else if (frame_hasher.get_result() == FrameHashResult::HASH_FAILED)
+    {
+        job->status = BatchStatus::BATCH_FAILED;
+        job->reason = "frame hash failed";
+    }
+    else if (serial_buffer.get_result() == SerialResult::SERIAL_PASSED)
+    {
+        job->status = BatchStatus::BATCH_PASSED;
+        job->reason = "serial output passed";
+    }
+    else if (frame_hasher.get_result() == FrameHashResult::HASH_PASSED)
+    {
+        job->status = BatchStatus::BATCH_PASSED;
+        job->reason = "frame hash passed";
+    }
+    else if (gameboy->reached_stop_cycle() && ! has_conditions)
+    {
+        job->status = BatchStatus::BATCH_PASSED;
+        job->reason = "ran to tick limit";
+    }
+    else
+    {
+        job->status = BatchStatus::BATCH_FAILED;
+        job->reason = "no result by tick limit";
+    }
+
+    job->frames = gameboy->get_vpu()->get_frame_count();
+    job->cycles = gameboy->get_scheduler()->get_cycle();
+    job->memory_hash = gameboy->hash_memory();
+    job->host_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+}
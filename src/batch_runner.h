@@ -0,0 +1,62 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// CPU ticks each ROM may run for, if not given in the manifest
+// or on the command line (~4 minutes of emulated time)
+#define BATCH_DEFAULT_MAX_TICKS 1000000000ULL
+
+enum BatchStatus {
+    BATCH_PASSED,
+    BATCH_FAILED,
+    // ROM could not be run
+    BATCH_ERROR
+};
+
+// Runs many ROMs headless, each in its own emulator instance, across
+// a pool of threads. ROMs are read from a manifest, one per line:
+//   <ROM path> [ticks=<max CPU ticks>] [pass=<serial text>] [fail=<serial text>] [hash=<frame:hash|!hash>] [state=<save state path>]
+// Each option may be repeated (other than ticks and state). With a
+// save state, the ROM starts from it rather than from power-on. A ROM passes once
+// any serial pass text or expected hash is seen, and fails on fail
+// text, a failed hash or reaching the tick limit. With no conditions,
+// a ROM passes by running to the tick limit.
+class BatchRunner {
+public:
+    BatchRunner(const char *bios_path, uint64_t default_max_ticks);
+
+    bool load(const char *manifest_path);
+    // Run all ROMs, printing a result line for each, returning
+    // whether all passed
+    bool run(unsigned int thread_count);
+
+private:
+    struct batch_job_t {
+        std::string rom_path;
+        uint64_t max_ticks;
+        std::vector<std::string> pass_patterns;
+        std::vector<std::string> fail_patterns;
+        std::vector<std::string> expected_hashes;
+        std::string state_path;
+
+        BatchStatus status;
+        std::string reason;
+        uint64_t frames;
+        uint64_t cycles;
+        uint64_t memory_hash;
+        double host_ms;
+    };
+
+    std::string bios_path;
+    uint64_t default_max_ticks;
+    std::vector<batch_job_t> jobs;
+
+    void run_job(batch_job_t *job);
+};
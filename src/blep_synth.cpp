@@ -0,0 +1,136 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+#include "blep_synth.h"
+
+#include <cmath>
+#include <string.h>
+
+BlepSynth::BlepSynth(AudioRing *ring, unsigned int sample_rate) :
+    RingOutput(ring, sample_rate),
+    resampler((double)CPU_CLOCK_HZ / BlepSynth::CYCLES_PER_SAMPLE, sample_rate)
+{
+    this->deltas_left.assign(BLEP_BUFFER_SAMPLES + BLEP_KERNEL_TAPS, 0.0f);
+    this->deltas_right.assign(BLEP_BUFFER_SAMPLES + BLEP_KERNEL_TAPS, 0.0f);
+    this->buffer_start = 0;
+    this->buffer_used = 0;
+    this->level_left = 0;
+    this->level_right = 0;
+    this->integrator_left = 0;
+    this->integrator_right = 0;
+
+    // Impulse is band-limited to a quarter of the intermediate rate,
+    // so anything that could alias into the audible range is removed
+    // before resampling
+    const double cutoff = 0.25;
+    this->kernel.resize(this->CYCLES_PER_SAMPLE * BLEP_KERNEL_TAPS);
+    for (unsigned int phase = 0; phase < this->CYCLES_PER_SAMPLE; phase ++)
+    {
+        float *coefficients = &this->kernel[phase * BLEP_KERNEL_TAPS];
+        double fraction = (double)phase / this->CYCLES_PER_SAMPLE;
+        double sum = 0;
+        for (unsigned int tap = 0; tap < BLEP_KERNEL_TAPS; tap ++)
+        {
+            double x = (double)tap - ((BLEP_KERNEL_TAPS / 2) - 1) - fraction;
+            double sinc = x == 0 ? 1.0 : sin(M_PI * 2 * cutoff * x) / (M_PI * 2 * cutoff * x);
+            // Blackman window
+            double w = (x / BLEP_KERNEL_TAPS) + 0.5;
+            double window = 0.42 - (0.5 * cos(2 * M_PI * w)) + (0.08 * cos(4 * M_PI * w));
+            coefficients[tap] = (float)(sinc * window);
+            sum += coefficients[tap];
+        }
+        // Each impulse integrates to a step of exactly the level change
+        for (unsigned int tap = 0; tap < BLEP_KERNEL_TAPS; tap ++)
+            coefficients[tap] = (float)(coefficients[tap] / sum);
+    }
+}
+
+void BlepSynth::set_cycle(uint64_t cycle)
+{
+    // Apply pending changes immediately, so the level is unchanged
+    for (unsigned int itx = 0; itx < this->buffer_used; itx ++)
+    {
+        this->integrator_left += this->deltas_left[itx];
+        this->integrator_right += this->deltas_right[itx];
+    }
+    memset(&this->deltas_left[0], 0, this->buffer_used * sizeof(float));
+    memset(&this->deltas_right[0], 0, this->buffer_used * sizeof(float));
+    this->buffer_used = 0;
+    this->buffer_start = cycle / this->CYCLES_PER_SAMPLE;
+}
+
+FirResampler *BlepSynth::get_resampler()
+{
+    return &this->resampler;
+}
+
+void BlepSynth::set_level(uint64_t cycle, int16_t left, int16_t right)
+{
+    // Make room, if the change is beyond the end of the buffer
+    if ((cycle / this->CYCLES_PER_SAMPLE) - this->buffer_start >= BLEP_BUFFER_SAMPLES)
+        this->run_until(cycle);
+
+    unsigned int index = (unsigned int)((cycle / this->CYCLES_PER_SAMPLE) - this->buffer_start);
+    const float *coefficients = &this->kernel[(cycle % this->CYCLES_PER_SAMPLE) * BLEP_KERNEL_TAPS];
+    float delta_left = (float)(left - this->level_left);
+    float delta_right = (float)(right - this->level_right);
+    for (unsigned int tap = 0; tap < BLEP_KERNEL_TAPS; tap ++)
+    {
+        this->deltas_left[index + tap] += coefficients[tap] * delta_left;
+        this->deltas_right[index + tap] += coefficients[tap] * delta_right;
+    }
+    if (index + BLEP_KERNEL_TAPS > this->buffer_used)
+        this->buffer_used = index + BLEP_KERNEL_TAPS;
+
+    this->level_left = left;
+    this->level_right = right;
+}
+
+void BlepSynth::run_until(uint64_t cycle)
+{
+    // Later changes can only affect samples from this one on
+    uint64_t end = cycle / this->CYCLES_PER_SAMPLE;
+    if (end <= this->buffer_start)
+        return;
+    unsigned int count = (unsigned int)(end - this->buffer_start);
+
+    for (unsigned int itx = 0; itx < count; itx ++)
+    {
+        // Level is constant after the last impulse
+        if (itx < this->buffer_used)
+        {
+            this->integrator_left += this->deltas_left[itx];
+            this->integrator_right += this->deltas_right[itx];
+        }
+        this->resampler.write(this->integrator_left, this->integrator_right);
+
+        float left, right;
+        while (this->resampler.read(left, right))
+            this->push_sample(left, right);
+    }
+
+    // Move remaining impulses to the start of the buffer
+    if (count < this->buffer_used)
+    {
+        unsigned int remaining = this->buffer_used - count;
+        memmove(&this->deltas_left[0], &this->deltas_left[count], remaining * sizeof(float));
+        memmove(&this->deltas_right[0], &this->deltas_right[count], remaining * sizeof(float));
+        memset(&this->deltas_left[remaining], 0, count * sizeof(float));
+        memset(&this->deltas_right[remaining], 0, count * sizeof(float));
+        this->buffer_used = remaining;
+    }
+    else
+    {
+        memset(&this->deltas_left[0], 0, this->buffer_used * sizeof(float));
+        memset(&this->deltas_right[0], 0, this->buffer_used * sizeof(float));
+        this->buffer_used = 0;
+    }
+    this->buffer_start = end;
+}
+
+void BlepSynth::set_rate_adjustment(double adjustment)
+{
+    this->resampler.set_ratio_adjustment(adjustment);
+}
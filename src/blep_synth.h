@@ -0,0 +1,57 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "ring_output.h"
+#include "fir_resampler.h"
+
+// Intermediate samples each level change is spread over
+#define BLEP_KERNEL_TAPS 16
+// Intermediate samples buffered before they must be resampled
+#define BLEP_BUFFER_SAMPLES 1024
+
+// Band-limited step synthesis. Each level change is added to an
+// intermediate buffer (at 1/32 of the CPU clock, 131072Hz) as a
+// band-limited impulse, placed to the exact cycle, which is then
+// integrated. Square, wave and noise edges therefore do not alias,
+// and the cost is per level change rather than per cycle. The
+// intermediate signal is then resampled to the host rate.
+class BlepSynth : public RingOutput {
+public:
+    BlepSynth(AudioRing *ring, unsigned int sample_rate);
+
+    void set_level(uint64_t cycle, int16_t left, int16_t right);
+    void run_until(uint64_t cycle);
+    void set_cycle(uint64_t cycle);
+    void set_rate_adjustment(double adjustment);
+
+    FirResampler *get_resampler();
+
+private:
+    // Cycles per intermediate sample, which is also the number of
+    // impulse phases, so that changes are placed to the cycle
+    static const uint64_t CYCLES_PER_SAMPLE = 32;
+
+    // Band-limited impulse for each phase, BLEP_KERNEL_TAPS per phase
+    std::vector<float> kernel;
+
+    // Impulses for intermediate samples, starting from buffer_start
+    std::vector<float> deltas_left;
+    std::vector<float> deltas_right;
+    uint64_t buffer_start;
+    // End of the buffer which may contain impulses
+    unsigned int buffer_used;
+
+    int16_t level_left;
+    int16_t level_right;
+    float integrator_left;
+    float integrator_right;
+
+    FirResampler resampler;
+};
@@ -54,15 +54,7 @@
 #define STOP_ON_BAD_OPCODE 1
 #define STOP_BEFORE_ROM 0
 
-signed int convert_signed_uint8_to_signed_int(uint8_t orig)
-{
-    if (orig & 0x80)
-        return (int)(0 - ((orig - 1) ^ 0xff));
-    else
-        return (int)orig;
-}
-
-int8_t convert_signed_uint8_to_int8(uint8_t orig)
+static int8_t convert_signed_uint8_to_int8(uint8_t orig)
 {
     if (orig & 0x80)
         return (int8_t)(0 - ((orig - 1) ^ 0xff));
@@ -91,7 +83,7 @@ void reg16::set_value(uint16_t new_value) {
 }
 
 
-CPU::CPU(RAM *ram, VPU *vpu_inst)
+CPU::CPU(RAM *ram, VPU *vpu_inst, Scheduler *scheduler, InterruptController *interrupts)
 {
     this->r_a = accumulator();
     this->r_f = gen_reg();
@@ -118,6 +110,9 @@ CPU::CPU(RAM *ram, VPU *vpu_inst)
 
     this->ram = ram;
     this->vpu_inst = vpu_inst;
+    this->scheduler = scheduler;
+    this->interrupts = interrupts;
+    this->instruction_count = 0;
     this->reset_state();
 }
 
@@ -133,9 +128,11 @@ void CPU::reset_state()
     this->r_l.set_value(0);
 
     this->h_blank_executed = false;
+    this->v_blank_executed = false;
 
     this->cb_state = false;
-    this->timer_itx = 0;
+    this->op_val = 0;
+    this->current_op_ticks = 0;
 
     this->interrupt_state = this->INTERRUPT_STATE::DISABLED;
     this->halt_state = false;
@@ -148,7 +145,7 @@ void CPU::reset_state()
 
     this->running = true;
     this->stepped_in = false;
-    this->timer_overflow = false;
+    this->debug_opcode = false;
     
     const uint8_t initial_ff00_memory_values[48] = {
         0xcf, 0x00, 0x7e, 0xff, 0x00, 0x00, 0x00, 0xf8,
@@ -159,6 +156,46 @@ void CPU::reset_state()
         this->ram->set(0xff00 + mem_itx, initial_ff00_memory_values[mem_itx]);
 }
 
+void CPU::save_state(cpu_state_t &state)
+{
+    state.a = this->r_a.get_value();
+    state.f = this->r_f.get_value();
+    state.b = this->r_b.get_value();
+    state.c = this->r_c.get_value();
+    state.d = this->r_d.get_value();
+    state.e = this->r_e.get_value();
+    state.h = this->r_h.get_value();
+    state.l = this->r_l.get_value();
+    state.sp = this->r_sp.get_value();
+    state.pc = this->r_pc.get_value();
+    state.interrupt_state = (uint8_t)this->interrupt_state;
+    state.halt_state = this->halt_state;
+    state.cb_state = this->cb_state;
+    state.current_op_ticks = this->current_op_ticks;
+    state.op_val = this->op_val;
+    state.tick_counter = this->tick_counter;
+}
+
+void CPU::load_state(const cpu_state_t &state)
+{
+    this->r_a.set_value(state.a);
+    this->r_f.set_value(state.f);
+    this->r_b.set_value(state.b);
+    this->r_c.set_value(state.c);
+    this->r_d.set_value(state.d);
+    this->r_e.set_value(state.e);
+    this->r_h.set_value(state.h);
+    this->r_l.set_value(state.l);
+    this->r_sp.set_value(state.sp);
+    this->r_pc.set_value(state.pc);
+    this->interrupt_state = (INTERRUPT_STATE)state.interrupt_state;
+    this->halt_state = state.halt_state;
+    this->cb_state = state.cb_state;
+    this->current_op_ticks = state.current_op_ticks;
+    this->op_val = state.op_val;
+    this->tick_counter = state.tick_counter;
+}
+
 void CPU::stop() {
     this->running = false;
 }
@@ -167,11 +204,32 @@ bool CPU::is_running() {
     return this->running;
 }
 
-int CPU::get_tick_counter()
+uint64_t CPU::get_tick_counter()
 {
     return this->tick_counter;
 }
 
+void CPU::run_until_event()
+{
+    while (this->running && this->scheduler->get_cycle() < this->scheduler->get_next_event_cycle())
+    {
+        // Whilst halted, nothing changes until an event occurs, unless
+        // an interrupt is pending or interrupts are being enabled/disabled
+        if (this->halt_state && ! this->interrupts->has_pending() &&
+            (this->interrupt_state == this->INTERRUPT_STATE::DISABLED ||
+             this->interrupt_state == this->INTERRUPT_STATE::ENABLED))
+        {
+            uint64_t skipped = this->scheduler->get_next_event_cycle() - this->scheduler->get_cycle();
+            this->tick_counter += skipped;
+            this->scheduler->advance(skipped);
+            return;
+        }
+
+        this->tick();
+        this->scheduler->advance(1);
+    }
+}
+
 void CPU::tick() {
     this->tick_counter ++;
 
@@ -194,13 +252,21 @@ void CPU::tick() {
         }
     }
     
-//    if (this->get_timer_state())
-    this->increment_timer();
-    
-    // Check for interrupts if internal state is true
-    if (this->interrupt_state == this->INTERRUPT_STATE::ENABLED ||
+    // Interrupts are serviced between instructions, with a single
+    // check whilst none are pending
+    if (this->interrupts->has_pending() &&
+        ((this->current_op_ticks == 0 && ! this->cb_state) || this->halt_state))
+    {
+        // Any pending interrupt ends halt, even if interrupts are disabled
+        this->halt_state = false;
+
+        if (this->interrupt_state == this->INTERRUPT_STATE::ENABLED ||
             this->interrupt_state == this->INTERRUPT_STATE::PENDING_DISABLE)
-        this->check_interrupts();
+        {
+            this->service_interrupt();
+            return;
+        }
+    }
 
     // Check if interrupt state is in a pending state
     // and move to actual state, since a clock cycle has been waited
@@ -241,6 +307,7 @@ void CPU::tick() {
         this->cb_state = false;
     } else {
         this->current_op_ticks = this->execute_op_code(this->op_val);
+        this->instruction_count ++;
     }
 
     // Stop runnign when we hit the start of the ROM
@@ -296,39 +363,6 @@ void CPU::debug_post_tick()
     }
 }
 
-bool CPU::get_timer_state()
-{
-    return (this->ram->get_ram_bit(this->TAC_TIMER_CONTROL_MEM_ADDRESS, 0x02) == 0x1);
-}
-
-void CPU::increment_timer()
-{
-    unsigned int freq = this->TIMER_FREQ[this->ram->get_val(this->TAC_TIMER_CONTROL_MEM_ADDRESS) & 0x03];
-    this->timer_itx ++;
-//    std::cout << "INcrmeenting timer!" << std::endl;
-//    // If CPU count since last tick is greater/equal to CPU frequency/timer frequency
-    // increment timer in mem
-    if (this->timer_itx >= (this->CPU_FREQ / freq))
-    {
-        this->timer_itx = 0;
-        this->ram->inc(this->TIMA_TIMER_COUNTER_ADDRESS);
-        //std::cout << "Timer tick!" << std::endl;
-        
-        // Check if timer overflowed
-        if (this->get_timer_state() && this->ram->get_val(this->TIMA_TIMER_COUNTER_ADDRESS) == 0)
-        {
-            // Set timer interrupt
-            this->ram->set_ram_bit(this->ram->INTERRUPT_IF_REGISTER_ADDRESS, 3, 1);
-            // Reset counter value back to moduli
-            this->ram->set(
-                this->TIMA_TIMER_COUNTER_ADDRESS,
-                // Perform XOR with 0xff to convert timer modulus to start value
-                0xff ^ this->ram->get_val(this->TMA_TIMER_INTERRUPT_MODULO_ADDRESS)
-            );
-        }
-    }
-}
-
 void CPU::print_state_m() {
     std::cout << std::hex <<
         "CPU Count: " << this->tick_counter << std::endl <<
@@ -348,66 +382,19 @@ void CPU::print_state_m() {
         "pc: " << std::setfill('0') << std::setw(4) << this->r_pc.get_value() << std::endl;
 }
 
-void CPU::check_interrupts() {
-
-    // Check if VLBANK has been triggered and interrupt is enabled
-    if (this->ram->get_ram_bit(this->ram->INTERRUPT_IF_REGISTER_ADDRESS, 0) &&
-        this->ram->get_ram_bit(this->ram->INTERRUPT_IE_REGISTER_ADDRESS, 0))
-    {
-
-        // Reset interrupt user interrupt bit
-        this->ram->set_ram_bit(this->ram->INTERRUPT_IF_REGISTER_ADDRESS, 0, 0);
-
-        if (INTERRUPT_DEBUG || DEBUG || this->stepped_in)
-            std::cout << "Got VLBANK INTERRUPT!" << std::endl;
-
-        // Push current pointer to stack and update PC to
-        // interrupt address
-        this->ram->stack_push(this->r_sp.get_pointer(), this->r_pc.get_value());
-        this->r_pc.set_value(this->ram->get_val(this->VBLANK_INTERRUPT_PTR_ADDR));
-        
-        // Do not process any more interrupts
-        return;
-    }
-
-
-    // Check if LCD Status has been triggered and interrupt is enabled
-    if (this->ram->get_ram_bit(this->ram->INTERRUPT_IF_REGISTER_ADDRESS, 1) &&
-        this->ram->get_ram_bit(this->ram->INTERRUPT_IE_REGISTER_ADDRESS, 1))
-    {
-        // Reset interrupt user interrupt bit
-        this->ram->set_ram_bit(this->ram->INTERRUPT_IF_REGISTER_ADDRESS, 1, 0);
-
-        if (INTERRUPT_DEBUG || DEBUG || this->stepped_in)
-            std::cout << "Got STAT INTERRUPT!" << std::endl;
-
-        // Push current pointer to stack and update PC to
-        // interrupt address
-        this->ram->stack_push(this->r_sp.get_pointer(), this->r_pc.get_value());
-        this->r_pc.set_value(this->ram->get_val(this->LCDC_STATUS_INTERRUPT_PTR_ADDR));
-
-        // Do not process any more interrupts
-        return;
-    }
-
-
-    // Check if timer has been triggered and interrupt is enabled
-    if (this->ram->get_ram_bit(this->ram->INTERRUPT_IF_REGISTER_ADDRESS, 2) &&
-        this->ram->get_ram_bit(this->ram->INTERRUPT_IE_REGISTER_ADDRESS, 2))
-    {
-        // Reset interrupt user interrupt bit
-        this->ram->set_ram_bit(this->ram->INTERRUPT_IF_REGISTER_ADDRESS, 3, 0);
-
-        if (INTERRUPT_DEBUG || DEBUG || this->stepped_in)
-            std::cout << "Got TIMER INTERRUPT!" << std::endl;
+void CPU::service_interrupt()
+{
+    uint16_t vector = this->interrupts->acknowledge();
+    if (INTERRUPT_DEBUG || DEBUG || this->stepped_in)
+        std::cout << "Servicing interrupt: " << std::hex << vector << std::endl;
 
-        // Push current pointer to stack and update PC to
-        // interrupt address
-        this->ram->stack_push(this->r_sp.get_pointer(), this->r_pc.get_value());
-        this->r_pc.set_value(this->ram->get_val(this->TIMER_INTERRUPT_PTR_ADDR));
+    // Further interrupts are disabled until re-enabled (e.g. by RETI)
+    this->interrupt_state = this->INTERRUPT_STATE::DISABLED;
 
-        return;
-    }
+    // Push current pointer to stack and jump to interrupt vector
+    this->ram->stack_push(this->r_sp.get_pointer(), this->r_pc.get_value());
+    this->r_pc.set_value(vector);
+    this->current_op_ticks = this->INTERRUPT_DISPATCH_CYCLES;
 }
 
 uint8_t CPU::execute_op_code(unsigned int op_val) {
@@ -2853,7 +2840,7 @@ void CPU::op_Sub(uint8_t src) {
 //        this->set_register_bit(&this->r_f, this->CARRY_FLAG_BIT, 0U);
 //    }
 
-    if (this->op_val == 0xde) {
+    if (DEBUG && this->op_val == 0xde) {
     std::cout << std::endl;
     std::cout << std::hex << "original value: " << (unsigned int)original_val << std::endl;
 
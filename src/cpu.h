@@ -8,6 +8,8 @@
 #include <memory>
 #include "./ram.h"
 #include "./vpu.h"
+#include "./scheduler.h"
+#include "./interrupt_controller.h"
 
 // Stub-class for friend
 class TestRunner;
@@ -55,18 +57,47 @@ public:
     };
 };
 
+// Saved registers and execution state, including
+// the remaining cycles of the current instruction
+struct cpu_state_t {
+    uint8_t a;
+    uint8_t f;
+    uint8_t b;
+    uint8_t c;
+    uint8_t d;
+    uint8_t e;
+    uint8_t h;
+    uint8_t l;
+    uint16_t sp;
+    uint16_t pc;
+    uint8_t interrupt_state;
+    bool halt_state;
+    bool cb_state;
+    uint8_t current_op_ticks;
+    unsigned int op_val;
+    uint64_t tick_counter;
+};
+
 class CPU {
     friend TestRunner;
 
 public:
-    explicit CPU(RAM *ram, VPU *vpu_inst);
+    explicit CPU(RAM *ram, VPU *vpu_inst, Scheduler *scheduler, InterruptController *interrupts);
     virtual ~CPU() {};
 
     void tick();
+    // Execute until the next scheduled event is due
+    void run_until_event();
     bool is_running();
     void stop();
     void reset_state();
-    int get_tick_counter();
+    uint64_t get_tick_counter();
+    // Instructions executed, with CB-prefixed instructions counted once
+    uint64_t get_instruction_count() {
+        return this->instruction_count;
+    };
+    void save_state(cpu_state_t &state);
+    void load_state(const cpu_state_t &state);
     //void print_state();
 protected:
     enum INTERRUPT_STATE {
@@ -79,7 +110,6 @@ protected:
     bool halt_state;
     bool cb_state;
     bool stepped_in;
-    unsigned int timer_itx;
     unsigned int op_val;
 
     union {
@@ -93,7 +123,8 @@ protected:
         uint32_t bit32[1];
     } data_conv32;
 
-    int tick_counter = 0;
+    // Cycles run, including those skipped whilst halted
+    uint64_t tick_counter = 0;
 
     // Bits for flag register
     // C flag
@@ -105,19 +136,9 @@ protected:
     // Z flag
     const int ZERO_FLAG_BIT = 7;
 
-    const int CPU_FREQ = 4000000;
-
-    // Interupts  
-    const uint16_t VBLANK_INTERRUPT_PTR_ADDR = 0x0040;
-    
-    const uint16_t LCDC_STATUS_INTERRUPT_PTR_ADDR = 0x0048;
 
-    // Timer config
-    const int TIMER_FREQ[4] = {4096, 262144, 65536, 16384};
-    const uint16_t TIMA_TIMER_COUNTER_ADDRESS = 0xff05;
-    const uint16_t TMA_TIMER_INTERRUPT_MODULO_ADDRESS = 0xff06;
-    const uint16_t TAC_TIMER_CONTROL_MEM_ADDRESS = 0xff07;
-    const uint16_t TIMER_INTERRUPT_PTR_ADDR = 0x0050;
+    // Cycles taken to push PC and jump to an interrupt vector
+    const uint8_t INTERRUPT_DISPATCH_CYCLES = 20;
 
     // Registers
     //  Accumulator
@@ -156,16 +177,12 @@ protected:
     // Current ticks to execute operation
     uint8_t current_op_ticks;
 
-    void check_interrupts();
+    void service_interrupt();
     int checked_op_codes[1000];
     int checked_op_codes_itx;
     int checked_cb_codes[1000];
     int checked_cb_codes_itx;
     
-    // Timer
-    bool get_timer_state();
-    void increment_timer();
-    bool timer_overflow;
     
     bool h_blank_executed;
     bool v_blank_executed;
@@ -303,7 +320,10 @@ protected:
 
     RAM *ram;
     VPU *vpu_inst;
+    Scheduler *scheduler;
+    InterruptController *interrupts;
     bool running;
+    uint64_t instruction_count;
     
     void debug_op_codes(unsigned int op_val);
     void debug_post_tick();
@@ -0,0 +1,203 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+#include "display.h"
+
+#include <iostream>
+#include <chrono>
+
+Display::Display(GameBoy *gameboy)
+{
+    this->gameboy = gameboy;
+    this->frames = gameboy->get_vpu()->get_frame_buffers();
+    this->stats = gameboy->get_stats();
+    this->window = nullptr;
+    this->renderer = nullptr;
+    this->texture = nullptr;
+    this->stop_requested = false;
+}
+
+bool Display::set_up()
+{
+    if (SDL_InitSubSystem(SDL_INIT_VIDEO | SDL_INIT_GAMECONTROLLER) != 0)
+    {
+        std::cout << "Unable to initialise display: " << SDL_GetError() << std::endl;
+        return false;
+    }
+    this->window = SDL_CreateWindow("Gameboy Emu",
+        0, 0, this->SCREEN_WIDTH, this->SCREEN_HEIGHT, 0);
+    if (this->window == nullptr)
+    {
+        std::cout << "Unable to create window: " << SDL_GetError() << std::endl;
+        return false;
+    }
+    // Presentation may wait for vsync, as it no longer holds up emulation
+    this->renderer = SDL_CreateRenderer(this->window, -1, SDL_RENDERER_PRESENTVSYNC);
+    // Frames are copied to the window through a texture
+    this->texture = SDL_CreateTexture(this->renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING,
+        this->SCREEN_WIDTH, this->SCREEN_HEIGHT);
+    return true;
+}
+
+void Display::tear_down()
+{
+    if (this->texture != nullptr)
+        SDL_DestroyTexture(this->texture);
+    if (this->renderer != nullptr)
+        SDL_DestroyRenderer(this->renderer);
+    if (this->window != nullptr)
+        SDL_DestroyWindow(this->window);
+    // Audio may still be open, so SDL is shut down by the caller
+    SDL_QuitSubSystem(SDL_INIT_VIDEO | SDL_INIT_GAMECONTROLLER);
+}
+
+void Display::run()
+{
+    if (! this->set_up())
+    {
+        // Stop emulation, since there is nothing to display to
+        this->quit();
+        this->tear_down();
+        return;
+    }
+
+    while (! this->stop_requested.load(std::memory_order_relaxed))
+    {
+        if (this->frames->consume())
+            this->present();
+
+        // Wait briefly for events, rather than spinning whilst
+        // waiting for the next frame
+        SDL_Event event;
+        if (SDL_WaitEventTimeout(&event, this->EVENT_WAIT_MS))
+        {
+            this->handle_event(event);
+            while (SDL_PollEvent(&event) != 0)
+                this->handle_event(event);
+        }
+    }
+
+    this->tear_down();
+}
+
+void Display::stop()
+{
+    this->stop_requested.store(true, std::memory_order_relaxed);
+}
+
+void Display::present()
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    SDL_UpdateTexture(this->texture, NULL, this->frames->get_read_buffer()->pixels,
+        this->SCREEN_WIDTH * sizeof(uint32_t));
+    SDL_RenderCopy(this->renderer, this->texture, NULL, NULL);
+    SDL_RenderPresent(this->renderer);
+    RuntimeStats::add(this->stats->present_ns,
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+    RuntimeStats::add(this->stats->frames_presented);
+}
+
+void Display::handle_event(SDL_Event &event)
+{
+    switch(event.type) {
+        case SDL_WINDOWEVENT:
+            if (event.window.event == SDL_WINDOWEVENT_CLOSE)
+                this->quit();
+            break;
+
+        case SDL_QUIT:
+            this->quit();
+            break;
+
+        // Check for keyboard events
+        case SDL_KEYDOWN:
+            // Ignore key repeat, as the button is already held
+            if (event.key.repeat)
+                break;
+            if (event.key.keysym.sym == SDLK_ESCAPE)
+                this->quit();
+            else if (this->get_key_button(event.key.keysym.sym) != JOYPAD_BUTTON_COUNT)
+                this->push_event(InputEventType::INPUT_BUTTON_DOWN, this->get_key_button(event.key.keysym.sym));
+            else
+                this->push_event(InputEventType::INPUT_KEY_DOWN, event.key.keysym.sym);
+            break;
+
+        case SDL_KEYUP:
+            if (this->get_key_button(event.key.keysym.sym) != JOYPAD_BUTTON_COUNT)
+                this->push_event(InputEventType::INPUT_BUTTON_UP, this->get_key_button(event.key.keysym.sym));
+            else
+                this->push_event(InputEventType::INPUT_KEY_UP, event.key.keysym.sym);
+            break;
+
+        // Game controllers are opened when connected, and are
+        // closed by SDL_Quit
+        case SDL_CONTROLLERDEVICEADDED:
+            if (SDL_IsGameController(event.cdevice.which))
+                SDL_GameControllerOpen(event.cdevice.which);
+            break;
+
+        case SDL_CONTROLLERBUTTONDOWN:
+            if (this->get_controller_button(event.cbutton.button) != JOYPAD_BUTTON_COUNT)
+                this->push_event(InputEventType::INPUT_BUTTON_DOWN, this->get_controller_button(event.cbutton.button));
+            break;
+
+        case SDL_CONTROLLERBUTTONUP:
+            if (this->get_controller_button(event.cbutton.button) != JOYPAD_BUTTON_COUNT)
+                this->push_event(InputEventType::INPUT_BUTTON_UP, this->get_controller_button(event.cbutton.button));
+            break;
+    }
+}
+
+JoypadButton Display::get_key_button(SDL_Keycode key)
+{
+    switch (key)
+    {
+        case SDLK_RIGHT: return JOYPAD_RIGHT;
+        case SDLK_LEFT: return JOYPAD_LEFT;
+        case SDLK_UP: return JOYPAD_UP;
+        case SDLK_DOWN: return JOYPAD_DOWN;
+        case SDLK_x: return JOYPAD_A;
+        case SDLK_z: return JOYPAD_B;
+        case SDLK_BACKSPACE: return JOYPAD_SELECT;
+        case SDLK_RETURN: return JOYPAD_START;
+        default: return JOYPAD_BUTTON_COUNT;
+    }
+}
+
+JoypadButton Display::get_controller_button(uint8_t controller_button)
+{
+    switch (controller_button)
+    {
+        case SDL_CONTROLLER_BUTTON_DPAD_RIGHT: return JOYPAD_RIGHT;
+        case SDL_CONTROLLER_BUTTON_DPAD_LEFT: return JOYPAD_LEFT;
+        case SDL_CONTROLLER_BUTTON_DPAD_UP: return JOYPAD_UP;
+        case SDL_CONTROLLER_BUTTON_DPAD_DOWN: return JOYPAD_DOWN;
+        case SDL_CONTROLLER_BUTTON_A: return JOYPAD_A;
+        case SDL_CONTROLLER_BUTTON_B: return JOYPAD_B;
+        case SDL_CONTROLLER_BUTTON_BACK: return JOYPAD_SELECT;
+        case SDL_CONTROLLER_BUTTON_START: return JOYPAD_START;
+        default: return JOYPAD_BUTTON_COUNT;
+    }
+}
+
+void Display::push_event(InputEventType type, int32_t key)
+{
+    input_event_t input_event;
+    input_event.type = type;
+    input_event.key = key;
+    // If the emulation thread is not keeping up, drop the event
+    this->events.push(input_event);
+}
+
+void Display::quit()
+{
+    this->gameboy->stop();
+    this->push_event(InputEventType::INPUT_QUIT, 0);
+}
+
+bool Display::poll_event(input_event_t &event)
+{
+    return this->events.pop(event);
+}
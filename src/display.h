@@ -0,0 +1,78 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+#pragma once
+
+#include <memory>
+#include <atomic>
+#include <SDL.h>
+
+#include "frame_buffer.h"
+#include "triple_buffer.h"
+#include "spsc_queue.h"
+#include "gameboy.h"
+
+enum InputEventType {
+    INPUT_QUIT,
+    INPUT_KEY_DOWN,
+    INPUT_KEY_UP,
+    // Joypad button, from a mapped key or controller button
+    INPUT_BUTTON_DOWN,
+    INPUT_BUTTON_UP
+};
+
+// Input from the display, passed back to the emulation thread
+struct input_event_t {
+    InputEventType type;
+    // SDL key code, or joypad button
+    int32_t key;
+};
+
+// Presents completed frames and collects input events.
+// This runs on its own thread (the main thread, as required by SDL on
+// some platforms), so that vsync or compositor stalls do not hold up
+// emulation. Frames are received through a triple buffer and input
+// events are passed back through a queue, so neither side blocks.
+class Display {
+public:
+    Display(GameBoy *gameboy);
+
+    // Present frames and process events on the calling thread, until stop() is called
+    void run();
+    // Can be called from any thread
+    void stop();
+
+    // Emulation thread - obtain next input event
+    bool poll_event(input_event_t &event);
+
+private:
+    const unsigned int SCREEN_WIDTH = SCREEN_PIXEL_WIDTH;
+    const unsigned int SCREEN_HEIGHT = SCREEN_PIXEL_HEIGHT;
+    // Time to wait for events, whilst there is no new frame
+    const int EVENT_WAIT_MS = 1;
+
+    SDL_Window *window;
+    SDL_Renderer *renderer;
+    SDL_Texture *texture;
+
+    GameBoy *gameboy;
+    TripleBuffer<frame_buffer_t> *frames;
+    RuntimeStats *stats;
+    SpscQueue<input_event_t, 256> events;
+    std::atomic<bool> stop_requested;
+
+    bool set_up();
+    void tear_down();
+    void present();
+    void handle_event(SDL_Event &event);
+    // Map key or controller button to joypad button,
+    // returning JOYPAD_BUTTON_COUNT if not mapped
+    JoypadButton get_key_button(SDL_Keycode key);
+    JoypadButton get_controller_button(uint8_t controller_button);
+    void push_event(InputEventType type, int32_t key);
+    // Stop emulation directly, as it may not be polling for events
+    // (e.g. whilst paused), then notify the emulation thread
+    void quit();
+};
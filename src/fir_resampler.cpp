@@ -0,0 +1,92 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+#include "fir_resampler.h"
+
+#include <cmath>
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
+FirResampler::FirResampler(double input_rate, double output_rate)
+{
+    this->nominal_step = input_rate / output_rate;
+    this->step = this->nominal_step;
+    this->history_left.assign(FIR_RESAMPLER_HISTORY * 2, 0.0f);
+    this->history_right.assign(FIR_RESAMPLER_HISTORY * 2, 0.0f);
+    this->input_count = 0;
+    this->position = 0;
+    this->position_fraction = 0;
+
+    // Pass band ends below the output Nyquist rate, leaving the
+    // window's transition band before the first alias
+    double cutoff = (0.42 * output_rate) / input_rate;
+    this->kernel.resize(FIR_RESAMPLER_PHASES * FIR_RESAMPLER_TAPS);
+    for (unsigned int phase = 0; phase < FIR_RESAMPLER_PHASES; phase ++)
+    {
+        float *coefficients = &this->kernel[phase * FIR_RESAMPLER_TAPS];
+        double fraction = (double)phase / FIR_RESAMPLER_PHASES;
+        double sum = 0;
+        for (unsigned int tap = 0; tap < FIR_RESAMPLER_TAPS; tap ++)
+        {
+            // Distance from output sample, which is centred in the window
+            double x = (double)tap - ((FIR_RESAMPLER_TAPS / 2) - 1) - fraction;
+            double sinc = x == 0 ? 1.0 : sin(M_PI * 2 * cutoff * x) / (M_PI * 2 * cutoff * x);
+            // Blackman window
+            double w = (x / FIR_RESAMPLER_TAPS) + 0.5;
+            double window = 0.42 - (0.5 * cos(2 * M_PI * w)) + (0.08 * cos(4 * M_PI * w));
+            coefficients[tap] = (float)(sinc * window);
+            sum += coefficients[tap];
+        }
+        // Unity gain at DC for every phase
+        for (unsigned int tap = 0; tap < FIR_RESAMPLER_TAPS; tap ++)
+            coefficients[tap] = (float)(coefficients[tap] / sum);
+    }
+}
+
+void FirResampler::set_ratio_adjustment(double adjustment)
+{
+    this->step = this->nominal_step * adjustment;
+}
+
+float FirResampler::dot_product(const float *a, const float *b)
+{
+#if defined(__SSE__)
+    // Independent accumulators, so additions can overlap
+    __m128 sum0 = _mm_setzero_ps();
+    __m128 sum1 = _mm_setzero_ps();
+    for (unsigned int tap = 0; tap < FIR_RESAMPLER_TAPS; tap += 8)
+    {
+        sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(&a[tap]), _mm_loadu_ps(&b[tap])));
+        sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(&a[tap + 4]), _mm_loadu_ps(&b[tap + 4])));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, _mm_add_ps(sum0, sum1));
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#else
+    float sum = 0;
+    for (unsigned int tap = 0; tap < FIR_RESAMPLER_TAPS; tap ++)
+        sum += a[tap] * b[tap];
+    return sum;
+#endif
+}
+
+bool FirResampler::read(float &left, float &right)
+{
+    if (this->input_count < this->position + FIR_RESAMPLER_TAPS)
+        return false;
+
+    unsigned int phase = (unsigned int)(this->position_fraction * FIR_RESAMPLER_PHASES);
+    const float *coefficients = &this->kernel[phase * FIR_RESAMPLER_TAPS];
+    unsigned int start = this->position & (FIR_RESAMPLER_HISTORY - 1);
+    left = FirResampler::dot_product(&this->history_left[start], coefficients);
+    right = FirResampler::dot_product(&this->history_right[start], coefficients);
+
+    this->position_fraction += this->step;
+    uint64_t whole = (uint64_t)this->position_fraction;
+    this->position += whole;
+    this->position_fraction -= whole;
+    return true;
+}
@@ -0,0 +1,61 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+// Number of input samples each output sample is filtered from
+#define FIR_RESAMPLER_TAPS 48
+// Number of fractional positions the filter is precalculated for
+#define FIR_RESAMPLER_PHASES 256
+// Input samples kept for filtering, which must be a power of 2
+#define FIR_RESAMPLER_HISTORY 1024
+
+// Stereo polyphase FIR resampler, converting from any input rate to a
+// lower output rate with a windowed-sinc low-pass filter, so that
+// frequencies above the output Nyquist rate do not alias.
+// Input history is kept contiguous so each output sample is a pair of
+// straight dot products, which use SSE where available.
+class FirResampler {
+public:
+    FirResampler(double input_rate, double output_rate);
+
+    // Adjust ratio of input to output samples, from the nominal
+    // ratio of the rates (e.g. 1.001 produces 0.1% fewer samples)
+    void set_ratio_adjustment(double adjustment);
+
+    // Add input sample
+    void write(float left, float right) {
+        unsigned int index = this->input_count & (FIR_RESAMPLER_HISTORY - 1);
+        // Written twice, so any window of taps is contiguous
+        this->history_left[index] = left;
+        this->history_left[index + FIR_RESAMPLER_HISTORY] = left;
+        this->history_right[index] = right;
+        this->history_right[index + FIR_RESAMPLER_HISTORY] = right;
+        this->input_count ++;
+    };
+    // Obtain next output sample, if enough input has been written
+    bool read(float &left, float &right);
+
+    static float dot_product(const float *a, const float *b);
+
+private:
+    double nominal_step;
+    // Input samples per output sample
+    double step;
+
+    // Coefficients for each phase, FIR_RESAMPLER_TAPS per phase
+    std::vector<float> kernel;
+    std::vector<float> history_left;
+    std::vector<float> history_right;
+    uint64_t input_count;
+
+    // Position of next output sample, as first input sample
+    // of its window and fraction of an input sample
+    uint64_t position;
+    double position_fraction;
+};
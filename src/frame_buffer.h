@@ -0,0 +1,17 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+#pragma once
+
+#include <memory>
+
+// Size of the screen, in pixels
+#define SCREEN_PIXEL_WIDTH 160
+#define SCREEN_PIXEL_HEIGHT 144
+
+// Completed frame of ARGB pixels
+struct frame_buffer_t {
+    uint32_t pixels[SCREEN_PIXEL_WIDTH * SCREEN_PIXEL_HEIGHT];
+};
@@ -0,0 +1,231 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+#include "frame_hasher.h"
+
+#include <iostream>
+#include <string.h>
+#include <inttypes.h>
+
+// xxHash64 primes
+#define XXH_PRIME64_1 0x9E3779B185EBCA87ULL
+#define XXH_PRIME64_2 0xC2B2AE3D27D4EB4FULL
+#define XXH_PRIME64_3 0x165667B19E3779F9ULL
+#define XXH_PRIME64_4 0x85EBCA77C2B2AE63ULL
+#define XXH_PRIME64_5 0x27D4EB2F165667C5ULL
+
+FrameHasher::FrameHasher()
+{
+    this->log = nullptr;
+    this->log_interval = 1;
+    this->result = FrameHashResult::HASH_PENDING;
+}
+
+FrameHasher::~FrameHasher()
+{
+    if (this->log != nullptr && this->log != stdout)
+        fclose(this->log);
+}
+
+bool FrameHasher::open_log(const char *path, unsigned int interval)
+{
+    this->log_interval = interval ? interval : 1;
+    this->log = strcmp(path, "-") == 0 ? stdout : fopen(path, "w");
+    if (this->log == nullptr)
+    {
+        std::cout << "Unable to open frame hash log: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool FrameHasher::add_expected(const char *spec)
+{
+    expected_hash_t expected_hash = {0, 0, false, false};
+    if (spec[0] == '!')
+    {
+        expected_hash.forbidden = true;
+        if (sscanf(&spec[1], "%" SCNx64, &expected_hash.hash) != 1)
+            return false;
+    }
+    else if (sscanf(spec, "%" SCNu64 ":%" SCNx64, &expected_hash.frame_number, &expected_hash.hash) != 2)
+    {
+        return false;
+    }
+    this->expected.push_back(expected_hash);
+    return true;
+}
+
+FrameHashResult FrameHasher::get_result()
+{
+    return this->result;
+}
+
+void FrameHasher::finish()
+{
+    if (this->log != nullptr)
+        fflush(this->log);
+
+    if (this->result != FrameHashResult::HASH_PENDING)
+        return;
+    for (auto &expected_hash : this->expected)
+        if (! expected_hash.forbidden && ! expected_hash.seen)
+        {
+            std::cout << "Frame hash " << std::hex << expected_hash.hash << " not seen before stopping" << std::endl;
+            this->result = FrameHashResult::HASH_FAILED;
+            return;
+        }
+}
+
+void FrameHasher::add_frame(uint64_t frame_number, const frame_buffer_t *frame)
+{
+    if (this->log == nullptr && this->expected.empty())
+        return;
+
+    uint64_t hash = FrameHasher::xxhash64(frame->pixels, sizeof(frame->pixels), 0);
+
+    if (this->log != nullptr && (frame_number % this->log_interval) == 0)
+        fprintf(this->log, "%" PRIu64 " %016" PRIx64 "\n", frame_number, hash);
+
+    if (this->result != FrameHashResult::HASH_PENDING || this->expected.empty())
+        return;
+
+    // Fail as soon as a forbidden hash is seen or an expected hash
+    // has not been seen in time, passing once all expected hashes are seen
+    bool all_seen = true;
+    for (auto &expected_hash : this->expected)
+    {
+        if (expected_hash.forbidden)
+        {
+            if (expected_hash.hash == hash)
+            {
+                std::cout << "Frame " << std::dec << frame_number << " matched forbidden hash " << std::hex << hash << std::endl;
+                this->result = FrameHashResult::HASH_FAILED;
+                return;
+            }
+            continue;
+        }
+
+        if (expected_hash.hash == hash)
+            expected_hash.seen = true;
+        if (expected_hash.seen)
+            continue;
+
+        all_seen = false;
+        if (frame_number >= expected_hash.frame_number)
+        {
+            std::cout << "Frame hash " << std::hex << expected_hash.hash << " not seen by frame " <<
+                std::dec << expected_hash.frame_number << " (last hash " << std::hex << hash << ")" << std::endl;
+            this->result = FrameHashResult::HASH_FAILED;
+            return;
+        }
+    }
+
+    // Only forbidden hashes must run until stopped
+    bool has_required = false;
+    for (auto &expected_hash : this->expected)
+        has_required |= ! expected_hash.forbidden;
+    if (all_seen && has_required)
+    {
+        std::cout << "Frame hashes matched at frame " << std::dec << frame_number << std::endl;
+        this->result = FrameHashResult::HASH_PASSED;
+    }
+}
+
+static inline uint64_t xxh_rotl64(uint64_t val, unsigned int bits)
+{
+    return (val << bits) | (val >> (64 - bits));
+}
+
+static inline uint64_t xxh_read64(const uint8_t *data)
+{
+    uint64_t val;
+    memcpy(&val, data, sizeof(val));
+    return val;
+}
+
+static inline uint32_t xxh_read32(const uint8_t *data)
+{
+    uint32_t val;
+    memcpy(&val, data, sizeof(val));
+    return val;
+}
+
+static inline uint64_t xxh_round(uint64_t acc, uint64_t input)
+{
+    acc += input * XXH_PRIME64_2;
+    acc = xxh_rotl64(acc, 31);
+    return acc * XXH_PRIME64_1;
+}
+
+static inline uint64_t xxh_merge_round(uint64_t acc, uint64_t val)
+{
+    acc ^= xxh_round(0, val);
+    return (acc * XXH_PRIME64_1) + XXH_PRIME64_4;
+}
+
+// xxHash64 reference algorithm, reading input as little-endian
+uint64_t FrameHasher::xxhash64(const void *data, size_t length, uint64_t seed)
+{
+    const uint8_t *input = (const uint8_t*)data;
+    const uint8_t *end = input + length;
+    uint64_t hash;
+
+    if (length >= 32)
+    {
+        const uint8_t *limit = end - 32;
+        uint64_t v1 = seed + XXH_PRIME64_1 + XXH_PRIME64_2;
+        uint64_t v2 = seed + XXH_PRIME64_2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - XXH_PRIME64_1;
+
+        do {
+            v1 = xxh_round(v1, xxh_read64(input));
+            v2 = xxh_round(v2, xxh_read64(input + 8));
+            v3 = xxh_round(v3, xxh_read64(input + 16));
+            v4 = xxh_round(v4, xxh_read64(input + 24));
+            input += 32;
+        } while (input <= limit);
+
+        hash = xxh_rotl64(v1, 1) + xxh_rotl64(v2, 7) + xxh_rotl64(v3, 12) + xxh_rotl64(v4, 18);
+        hash = xxh_merge_round(hash, v1);
+        hash = xxh_merge_round(hash, v2);
+        hash = xxh_merge_round(hash, v3);
+        hash = xxh_merge_round(hash, v4);
+    }
+    else
+    {
+        hash = seed + XXH_PRIME64_5;
+    }
+
+    hash += (uint64_t)length;
+
+    while (input + 8 <= end)
+    {
+        hash ^= xxh_round(0, xxh_read64(input));
+        hash = (xxh_rotl64(hash, 27) * XXH_PRIME64_1) + XXH_PRIME64_4;
+        input += 8;
+    }
+    if (input + 4 <= end)
+    {
+        hash ^= (uint64_t)xxh_read32(input) * XXH_PRIME64_1;
+        hash = (xxh_rotl64(hash, 23) * XXH_PRIME64_2) + XXH_PRIME64_3;
+        input += 4;
+    }
+    while (input < end)
+    {
+        hash ^= (*input) * XXH_PRIME64_5;
+        hash = xxh_rotl64(hash, 11) * XXH_PRIME64_1;
+        input ++;
+    }
+
+    // Avalanche
+    hash ^= hash >> 33;
+    hash *= XXH_PRIME64_2;
+    hash ^= hash >> 29;
+    hash *= XXH_PRIME64_3;
+    hash ^= hash >> 32;
+    return hash;
+}
@@ -0,0 +1,58 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <stdio.h>
+
+#include "frame_buffer.h"
+
+enum FrameHashResult {
+    // No expected hashes, or still waiting for them
+    HASH_PENDING,
+    HASH_PASSED,
+    HASH_FAILED
+};
+
+// Hashes drawn frames with xxHash64, for logging and comparing
+// against expected hashes, so that image tests can run without
+// a display or an image comparison tool.
+class FrameHasher {
+public:
+    FrameHasher();
+    ~FrameHasher();
+
+    // Log hash of every 'interval' frames to the given file ('-' for stdout)
+    bool open_log(const char *path, unsigned int interval);
+    // Parse expected hash, either:
+    //   <frame>:<hash> - pass once hash is seen, fail if not seen by frame
+    //   !<hash> - fail if hash is ever seen
+    bool add_expected(const char *spec);
+
+    // Called for each drawn frame, with the frame number since start-up
+    void add_frame(uint64_t frame_number, const frame_buffer_t *frame);
+
+    // Overall result, which is final once passed or failed
+    FrameHashResult get_result();
+    // Called when emulation stops, failing if expected hashes were not seen
+    void finish();
+
+    static uint64_t xxhash64(const void *data, size_t length, uint64_t seed);
+
+private:
+    struct expected_hash_t {
+        uint64_t hash;
+        uint64_t frame_number;
+        bool forbidden;
+        bool seen;
+    };
+
+    FILE *log;
+    unsigned int log_interval;
+    std::vector<expected_hash_t> expected;
+    FrameHashResult result;
+};
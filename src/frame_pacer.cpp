@@ -0,0 +1,171 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+#include "frame_pacer.h"
+
+#include <thread>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <algorithm>
+
+FramePacer::FramePacer(RuntimeStats *stats)
+{
+    this->stats = stats;
+    this->audio_ring = nullptr;
+    this->audio_output = nullptr;
+    this->audio_sample_rate = 0;
+    this->target_depth = 0;
+    this->smoothed_depth = 0;
+    this->max_depth = 0;
+    this->audio_primed = false;
+    this->audio_frame_count = 0;
+    this->depth_total = 0;
+    this->depth_min = 0;
+    this->depth_max = 0;
+    this->adjustment_min = 1.0;
+    this->adjustment_max = 1.0;
+    this->audio_wait_timeouts = 0;
+    this->set_speed(1.0);
+}
+
+void FramePacer::set_speed(double speed)
+{
+    this->speed = speed;
+    if (speed > 0)
+        this->frame_duration = std::chrono::nanoseconds((int64_t)(FRAME_DURATION_NS / speed));
+    this->reset();
+}
+
+double FramePacer::get_speed()
+{
+    return this->speed;
+}
+
+void FramePacer::set_audio_sync(AudioRing *ring, RingOutput *output, unsigned int sample_rate, double target_latency)
+{
+    this->audio_ring = ring;
+    this->audio_output = output;
+    this->audio_sample_rate = sample_rate;
+    // Leave room in the ring for a frame of samples above the maximum
+    double ring_depth = AUDIO_RING_FRAMES - (2.0 * sample_rate * FRAME_DURATION_NS / 1000000000.0);
+    this->target_depth = std::min(ring_depth / 2, (target_latency * sample_rate) / 1000.0);
+    this->max_depth = this->target_depth * 2;
+    this->smoothed_depth = this->target_depth;
+}
+
+void FramePacer::reset()
+{
+    this->start_time = std::chrono::steady_clock::now();
+    this->last_frame_time = this->start_time;
+    this->frame_count = 0;
+}
+
+void FramePacer::wait_for_frame()
+{
+    bool timed = this->speed > 0;
+    if (this->audio_ring != nullptr && ! this->audio_primed)
+    {
+        // Fill the queue to the target latency before timing frames,
+        // on start and after underruns, so playback is not starved
+        if (this->audio_ring->size() < this->target_depth)
+        {
+            timed = false;
+        }
+        else
+        {
+            this->audio_primed = true;
+            this->start_time = std::chrono::steady_clock::now();
+            this->frame_count = 0;
+        }
+    }
+
+    if (timed)
+    {
+        this->frame_count ++;
+        std::chrono::steady_clock::time_point due = this->start_time + (this->frame_duration * this->frame_count);
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+        if (now > due + (this->frame_duration * this->MAX_FRAMES_BEHIND))
+        {
+            // Too far behind (e.g. host was suspended), so start again from now
+            this->start_time = now;
+            this->frame_count = 0;
+        }
+        else
+        {
+            // Sleep for most of the remaining time, then spin until due
+            if (due - now > this->SPIN_DURATION)
+                std::this_thread::sleep_for((due - now) - this->SPIN_DURATION);
+            while (std::chrono::steady_clock::now() < due)
+                std::this_thread::yield();
+        }
+    }
+
+    if (this->audio_ring != nullptr)
+        this->wait_for_audio();
+
+    // Record time between frames, for jitter
+    std::chrono::steady_clock::time_point frame_time = std::chrono::steady_clock::now();
+    this->stats->add_frame_time(std::chrono::duration_cast<std::chrono::nanoseconds>(frame_time - this->last_frame_time).count());
+    this->last_frame_time = frame_time;
+}
+
+void FramePacer::wait_for_audio()
+{
+    // Wait for the device to play queued samples down to the maximum
+    std::chrono::steady_clock::time_point wait_start = std::chrono::steady_clock::now();
+    unsigned long depth = this->audio_ring->size();
+    while (depth > this->max_depth)
+    {
+        if (std::chrono::steady_clock::now() - wait_start > this->MAX_AUDIO_WAIT)
+        {
+            this->audio_wait_timeouts ++;
+            break;
+        }
+        std::this_thread::sleep_for(this->AUDIO_POLL_INTERVAL);
+        depth = this->audio_ring->size();
+    }
+    if (depth == 0)
+        this->audio_primed = false;
+
+    if (this->audio_frame_count == 0 || depth < this->depth_min)
+        this->depth_min = depth;
+    if (depth > this->depth_max)
+        this->depth_max = depth;
+    this->depth_total += depth;
+    this->audio_frame_count ++;
+
+    // Produce fewer samples whilst the queue is above target and
+    // more whilst it is below, in proportion to the error
+    this->smoothed_depth += (depth - this->smoothed_depth) * this->DEPTH_SMOOTHING;
+    double error = (this->smoothed_depth - this->target_depth) / this->target_depth;
+    double adjustment = 1.0 + std::max(-this->MAX_RATE_ADJUSTMENT,
+                                       std::min(this->MAX_RATE_ADJUSTMENT, error * this->MAX_RATE_ADJUSTMENT));
+    this->audio_output->set_rate_adjustment(adjustment);
+    this->adjustment_min = std::min(this->adjustment_min, adjustment);
+    this->adjustment_max = std::max(this->adjustment_max, adjustment);
+}
+
+void FramePacer::print_audio_stats()
+{
+    if (this->audio_ring == nullptr || this->audio_frame_count == 0)
+        return;
+
+    // Formatted locally, so std::cout keeps its own precision
+    double ms_per_sample = 1000.0 / this->audio_sample_rate;
+    std::ostringstream text;
+    text << std::fixed << std::setprecision(1) <<
+        "Audio queue latency (ms): target " << (this->target_depth * ms_per_sample) <<
+        ", mean " << ((this->depth_total / this->audio_frame_count) * ms_per_sample) <<
+        ", min " << (this->depth_min * ms_per_sample) <<
+        ", max " << (this->depth_max * ms_per_sample) << std::endl <<
+        std::setprecision(3) <<
+        "Audio rate adjustment (%): min " << ((this->adjustment_min - 1.0) * 100.0) <<
+        ", max " << ((this->adjustment_max - 1.0) * 100.0) << std::endl;
+    if (this->audio_wait_timeouts != 0)
+        text << "Audio sync: " << this->audio_wait_timeouts << " waits timed out" << std::endl;
+    std::cout << text.str() << std::flush;
+}
@@ -0,0 +1,92 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+#pragma once
+
+#include <memory>
+#include <chrono>
+
+#include "timing.h"
+#include "runtime_stats.h"
+#include "audio_ring.h"
+#include "ring_output.h"
+
+// Limits emulation to a multiple of the DMG frame rate, by waiting
+// at the end of each frame. Frames are scheduled against a fixed
+// start time, so that waiting errors do not accumulate.
+//
+// With audio sync, emulation is also synced to the audio device's
+// clock. As the host's audio clock does not run at exactly the same
+// rate as its timer, the rate samples are produced at is adjusted
+// slightly (without audible pitch change) to keep the queued audio
+// at the target latency. If the queue still exceeds twice the target,
+// the frame waits for the device to play it.
+class FramePacer {
+public:
+    FramePacer(RuntimeStats *stats);
+
+    // Run at the given multiple of real time, 0 for uncapped
+    void set_speed(double speed);
+    double get_speed();
+
+    // Pace against queued audio, with a target latency in milliseconds
+    void set_audio_sync(AudioRing *ring, RingOutput *output, unsigned int sample_rate, double target_latency);
+
+    // Called once per emulated frame, waiting until it is due
+    void wait_for_frame();
+
+    // Print target and measured audio latency
+    void print_audio_stats();
+
+private:
+    // Sleeping can overshoot by the scheduler granularity, so
+    // the final part of each wait spins
+    const std::chrono::nanoseconds SPIN_DURATION = std::chrono::microseconds(1500);
+    // When emulation falls this far behind, restart the schedule
+    // rather than running fast to catch up
+    const unsigned int MAX_FRAMES_BEHIND = 4;
+
+    // Largest rate adjustment, which is below audible pitch change
+    const double MAX_RATE_ADJUSTMENT = 0.005;
+    // Weight of each frame's queue depth in the smoothed depth, as
+    // the device consumes samples in blocks
+    const double DEPTH_SMOOTHING = 0.05;
+    // Longest wait for queued audio to be played, after which the
+    // device is assumed to have stopped and the frame continues
+    const std::chrono::nanoseconds MAX_AUDIO_WAIT = std::chrono::milliseconds(100);
+    const std::chrono::nanoseconds AUDIO_POLL_INTERVAL = std::chrono::microseconds(500);
+
+    RuntimeStats *stats;
+    double speed;
+    std::chrono::nanoseconds frame_duration;
+
+    std::chrono::steady_clock::time_point start_time;
+    std::chrono::steady_clock::time_point last_frame_time;
+    uint64_t frame_count;
+
+    // Audio sync, when audio_ring is set
+    AudioRing *audio_ring;
+    RingOutput *audio_output;
+    unsigned int audio_sample_rate;
+    // Target, smoothed and maximum queue depth, in samples
+    double target_depth;
+    double smoothed_depth;
+    double max_depth;
+    // Whether the queue has been filled to the target, after which
+    // frames are timed. Until then, emulation runs uncapped.
+    bool audio_primed;
+
+    // Measured queue depth at each frame and rate adjustments
+    uint64_t audio_frame_count;
+    double depth_total;
+    unsigned long depth_min;
+    unsigned long depth_max;
+    double adjustment_min;
+    double adjustment_max;
+    uint64_t audio_wait_timeouts;
+
+    void reset();
+    void wait_for_audio();
+};
@@ -0,0 +1,92 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+#include "frame_skip.h"
+
+FrameSkip::FrameSkip()
+{
+    this->set_disabled();
+}
+
+void FrameSkip::set_disabled()
+{
+    this->mode = MODE::DISABLED;
+    this->skip_frames = 0;
+    this->frames_since_render = 0;
+    this->target_cycle = 0;
+}
+
+void FrameSkip::set_fixed(unsigned int frames)
+{
+    this->set_disabled();
+    this->mode = MODE::FIXED;
+    this->skip_frames = frames;
+}
+
+void FrameSkip::set_auto()
+{
+    this->set_disabled();
+    this->mode = MODE::AUTO;
+    this->auto_start_time = std::chrono::steady_clock::now();
+    this->auto_frame_count = 0;
+}
+
+void FrameSkip::set_target_cycle(uint64_t cycle)
+{
+    this->set_disabled();
+    this->mode = MODE::TARGET_CYCLE;
+    this->target_cycle = cycle;
+}
+
+bool FrameSkip::should_render(uint64_t frame_end_cycle)
+{
+    bool render = true;
+    switch (this->mode)
+    {
+        case MODE::DISABLED:
+            return true;
+
+        case MODE::FIXED:
+            render = (this->frames_since_render >= this->skip_frames);
+            break;
+
+        case MODE::AUTO:
+            render = this->should_render_auto();
+            break;
+
+        case MODE::TARGET_CYCLE:
+            // Frame is only needed if it has not been fully
+            // replaced by a later frame by the target cycle
+            return (frame_end_cycle + FRAME_CYCLES) > this->target_cycle;
+    }
+
+    if (render)
+        this->frames_since_render = 0;
+    else
+        this->frames_since_render ++;
+    return render;
+}
+
+bool FrameSkip::should_render_auto()
+{
+    this->auto_frame_count ++;
+
+    // Determine how far behind real time emulation is running
+    std::chrono::steady_clock::duration elapsed = std::chrono::steady_clock::now() - this->auto_start_time;
+    std::chrono::nanoseconds expected = std::chrono::nanoseconds(FRAME_DURATION_NS) * this->auto_frame_count;
+
+    if (elapsed > (expected + std::chrono::nanoseconds(FRAME_DURATION_NS)) && this->frames_since_render < this->MAX_AUTO_SKIP)
+        return false;
+
+    // Do not allow emulation to build up time whilst running ahead
+    // (e.g. when paused or paced), so that it is not used later
+    // to avoid skipping
+    if (elapsed < expected)
+    {
+        this->auto_start_time = std::chrono::steady_clock::now();
+        this->auto_frame_count = 0;
+    }
+    return true;
+}
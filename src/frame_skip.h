@@ -0,0 +1,56 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+#pragma once
+
+#include <memory>
+#include <chrono>
+
+#include "timing.h"
+
+// Determines which frames are drawn. Skipped frames are still
+// emulated with exact timing, but no pixels are generated or presented.
+class FrameSkip {
+public:
+    FrameSkip();
+
+    // Draw every frame (default)
+    void set_disabled();
+    // Draw one frame, then skip the next 'frames' frames
+    void set_fixed(unsigned int frames);
+    // Skip frames whilst emulation is running slower than real time
+    void set_auto();
+    // Only draw frames that could be on-screen at the given cycle,
+    // e.g. for capturing a screenshot
+    void set_target_cycle(uint64_t cycle);
+
+    // Called at the start of each frame, returning whether
+    // the frame should be drawn
+    bool should_render(uint64_t frame_end_cycle);
+
+private:
+    enum MODE {
+        DISABLED,
+        FIXED,
+        AUTO,
+        TARGET_CYCLE
+    };
+    MODE mode;
+
+    // Limit consecutive skipped frames in auto mode, so that the display
+    // is still updated when the host cannot keep up
+    const unsigned int MAX_AUTO_SKIP = 8;
+
+    unsigned int skip_frames;
+    unsigned int frames_since_render;
+    uint64_t target_cycle;
+
+    // Host time at which auto frame skip started and
+    // number of frames emulated since then
+    std::chrono::steady_clock::time_point auto_start_time;
+    uint64_t auto_frame_count;
+
+    bool should_render_auto();
+};
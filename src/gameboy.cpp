@@ -0,0 +1,328 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+#include "gameboy.h"
+
+#include <iostream>
+#include <fstream>
+#include <iterator>
+#include <vector>
+#include <chrono>
+#include <string.h>
+
+#include "helper.h"
+
+GameBoy::GameBoy() :
+    interrupts(&this->ram),
+    vpu(&this->ram, &this->stats, &this->scheduler, &this->interrupts),
+    timer(&this->ram, &this->scheduler, &this->interrupts),
+    joypad(&this->ram, &this->interrupts),
+    serial(&this->ram, &this->scheduler, &this->interrupts),
+    apu(&this->ram, &this->scheduler),
+    cpu(&this->ram, &this->vpu, &this->scheduler, &this->interrupts),
+    stop_requested(false)
+{
+    this->rom_hash = 0;
+    this->stop_cycle_reached = false;
+    this->frame_hasher = nullptr;
+    this->serial_result = nullptr;
+    this->frame_end_cycle = this->scheduler.get_cycle() + FRAME_CYCLES;
+    this->stats_sample_count = 0;
+    this->reported_cycle = 0;
+    this->reported_instructions = 0;
+}
+
+bool GameBoy::load(const char *bios_path, const char *rom_path)
+{
+    arguments_t arguments = {{0, 0, 0, 0}};
+    strncpy(arguments.bios_path, bios_path, sizeof(arguments.bios_path) - 1);
+    strncpy(arguments.rom_path, rom_path, sizeof(arguments.rom_path) - 1);
+    if (! std::ifstream(arguments.bios_path).good())
+    {
+        std::cout << "Unable to open BIOS: " << bios_path << std::endl;
+        return false;
+    }
+    std::ifstream rom_file(arguments.rom_path, std::ios::binary);
+    if (! rom_file.good())
+    {
+        std::cout << "Unable to open ROM: " << rom_path << std::endl;
+        return false;
+    }
+    std::vector<char> rom_data((std::istreambuf_iterator<char>(rom_file)), std::istreambuf_iterator<char>());
+    this->rom_hash = FrameHasher::xxhash64(rom_data.data(), rom_data.size(), 0);
+
+    this->cpu.reset_state();
+    this->ram.load_bios(&arguments);
+    this->ram.load_rom(&arguments);
+    return true;
+}
+
+void GameBoy::set_stop_cycle(uint64_t cycle, const char *screenshot_path)
+{
+    this->screenshot_path = screenshot_path != nullptr ? screenshot_path : "";
+    this->scheduler.schedule(SchedulerEvent::EVENT_SCREENSHOT, cycle);
+}
+
+void GameBoy::set_frame_hasher(FrameHasher *frame_hasher)
+{
+    this->frame_hasher = frame_hasher;
+    this->vpu.set_frame_hasher(frame_hasher);
+}
+
+void GameBoy::set_serial_result(SerialBufferSink *serial_result)
+{
+    this->serial_result = serial_result;
+    this->serial.add_sink(serial_result);
+}
+
+void GameBoy::stop()
+{
+    this->stop_requested.store(true);
+}
+
+bool GameBoy::is_running()
+{
+    return this->cpu.is_running();
+}
+
+bool GameBoy::reached_stop_cycle()
+{
+    return this->stop_cycle_reached;
+}
+
+uint64_t GameBoy::hash_memory()
+{
+    return FrameHasher::xxhash64(this->ram.get_ref(0), MAX_MEM_SIZE, 0);
+}
+
+void GameBoy::save_state(gameboy_state_t &state)
+{
+    // Cleared first, so padding is identical between saves
+    memset(&state, 0, sizeof(state));
+    this->cpu.save_state(state.cpu);
+    this->ram.save_state(state.ram);
+    this->scheduler.save_state(state.scheduler);
+    this->interrupts.save_state(state.interrupts);
+    this->vpu.save_state(state.vpu);
+    this->timer.save_state(state.timer);
+    this->joypad.save_state(state.joypad);
+    this->serial.save_state(state.serial);
+    this->apu.save_state(state.apu);
+}
+
+void GameBoy::load_state(const gameboy_state_t &state)
+{
+    uint64_t stop_cycle = this->scheduler.get_event_cycle(SchedulerEvent::EVENT_SCREENSHOT);
+
+    // Memory and scheduler are restored first, as the VPU
+    // reads palettes from memory and the APU the current cycle
+    this->ram.load_state(state.ram);
+    this->scheduler.load_state(state.scheduler);
+    this->cpu.load_state(state.cpu);
+    this->interrupts.load_state(state.interrupts);
+    this->vpu.load_state(state.vpu);
+    this->timer.load_state(state.timer);
+    this->joypad.load_state(state.joypad);
+    this->serial.load_state(state.serial);
+    this->apu.load_state(state.apu);
+
+    if (stop_cycle != UINT64_MAX)
+        this->scheduler.schedule(SchedulerEvent::EVENT_SCREENSHOT, stop_cycle);
+    else
+        this->scheduler.cancel(SchedulerEvent::EVENT_SCREENSHOT);
+    this->stop_cycle_reached = false;
+    this->frame_end_cycle = this->scheduler.get_cycle() + FRAME_CYCLES;
+    // Cycles are counted from the loaded state
+    this->reported_cycle = this->scheduler.get_cycle();
+}
+
+uint64_t GameBoy::hash_state()
+{
+    std::unique_ptr<gameboy_state_t> state(new gameboy_state_t);
+    this->save_state(*state);
+
+    // The stop cycle is set by the host, rather than by emulation
+    state->scheduler.event_cycles[SchedulerEvent::EVENT_SCREENSHOT] = UINT64_MAX;
+    state->vpu.render_frame = false;
+    state->vpu.window_line = 0;
+    memset(state->vpu.line_sprites, 0, sizeof(state->vpu.line_sprites));
+    state->vpu.line_sprite_count = 0;
+    memset(&state->vpu.frame, 0, sizeof(state->vpu.frame));
+    state->apu.level_left = 0;
+    state->apu.level_right = 0;
+    for (unsigned int itx = 0; itx < 4; itx ++)
+    {
+        state->apu.channels[itx].next_step_cycle = 0;
+        state->apu.channels[itx].duty_position = 0;
+        state->apu.channels[itx].position = 0;
+        state->apu.channels[itx].lfsr = 0;
+    }
+    return FrameHasher::xxhash64(state.get(), sizeof(gameboy_state_t), 0);
+}
+
+bool GameBoy::save_state_file(const char *path)
+{
+    std::unique_ptr<gameboy_state_t> state(new gameboy_state_t);
+    this->save_state(*state);
+
+    save_state_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "GBST", sizeof(header.magic));
+    header.version = SAVE_STATE_VERSION;
+    header.size = sizeof(gameboy_state_t);
+    header.rom_hash = this->rom_hash;
+
+    std::ofstream state_file(path, std::ios::binary | std::ios::trunc);
+    state_file.write((const char*)&header, sizeof(header));
+    state_file.write((const char*)state.get(), sizeof(gameboy_state_t));
+    if (! state_file.good())
+    {
+        std::cout << "Unable to write save state: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool GameBoy::load_state_file(const char *path)
+{
+    std::ifstream state_file(path, std::ios::binary);
+    save_state_header_t header;
+    std::unique_ptr<gameboy_state_t> state(new gameboy_state_t);
+    state_file.read((char*)&header, sizeof(header));
+    if (! state_file.good() || memcmp(header.magic, "GBST", sizeof(header.magic)) != 0)
+    {
+        std::cout << "Unable to read save state: " << path << std::endl;
+        return false;
+    }
+    if (header.version != SAVE_STATE_VERSION || header.size != sizeof(gameboy_state_t))
+    {
+        std::cout << "Save state is from an incompatible version: " << path << std::endl;
+        return false;
+    }
+    if (header.rom_hash != this->rom_hash)
+    {
+        std::cout << "Save state is for a different ROM: " << path << std::endl;
+        return false;
+    }
+    state_file.read((char*)state.get(), sizeof(gameboy_state_t));
+    if (! state_file.good())
+    {
+        std::cout << "Save state is truncated: " << path << std::endl;
+        return false;
+    }
+
+    this->load_state(*state);
+    return true;
+}
+
+bool GameBoy::run_frame()
+{
+    while (this->cpu.is_running())
+    {
+        // Stop requests from other threads are picked up between
+        // events, which occur at least every APU frame sequencer step
+        if (this->stop_requested.load(std::memory_order_relaxed))
+        {
+            this->cpu.stop();
+            break;
+        }
+
+        bool sample = ++ this->stats_sample_count == this->STATS_SAMPLE_INTERVAL;
+        std::chrono::steady_clock::time_point sample_start;
+        if (sample)
+        {
+            this->stats_sample_count = 0;
+            sample_start = std::chrono::steady_clock::now();
+        }
+
+        // CPU runs until the next event is due, then all
+        // due events are processed
+        this->cpu.run_until_event();
+
+        if (sample)
+            RuntimeStats::add(this->stats.cpu_ns, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - sample_start).count() * this->STATS_SAMPLE_INTERVAL);
+
+        bool vblank = false;
+        SchedulerEvent event;
+        while (this->scheduler.pop_due_event(event))
+        {
+            switch (event)
+            {
+                case SchedulerEvent::EVENT_VPU:
+                {
+                    if (sample)
+                        sample_start = std::chrono::steady_clock::now();
+                    VpuEventType vpu_event = this->vpu.process_event();
+                    if (sample)
+                        RuntimeStats::add(this->stats.ppu_ns, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - sample_start).count() * this->STATS_SAMPLE_INTERVAL);
+                    if (vpu_event != VpuEventType::VBLANK)
+                        break;
+                    vblank = true;
+                    // Stop once frame hashes have passed or failed
+                    if (this->frame_hasher != nullptr && this->frame_hasher->get_result() != FrameHashResult::HASH_PENDING)
+                        this->cpu.stop();
+                    break;
+                }
+
+                case SchedulerEvent::EVENT_SCREENSHOT:
+                    if (! this->screenshot_path.empty())
+                    {
+                        this->vpu.capture_screenshot(this->screenshot_path.c_str());
+                        std::cout << "Captured Screenshot" << std::endl;
+                    }
+                    this->stop_cycle_reached = true;
+                    this->cpu.stop();
+                    break;
+
+                case SchedulerEvent::EVENT_TIMER:
+                    this->timer.overflow_event();
+                    break;
+
+                case SchedulerEvent::EVENT_APU:
+                    this->apu.frame_sequencer_event();
+                    break;
+
+                case SchedulerEvent::EVENT_SERIAL:
+                    this->serial.transfer_event();
+                    // Stop once serial output has passed or failed
+                    if (this->serial_result != nullptr && this->serial_result->get_result() != SerialResult::SERIAL_PENDING)
+                        this->cpu.stop();
+                    break;
+
+                default:
+                    break;
+            }
+        }
+
+        // No V-blank occurs whilst the LCD is off, so frames also end
+        // every frame of cycles, for the host to keep pacing and polling
+        // input. These deadlines follow on from each other, as events
+        // may be processed up to an APU frame sequencer step late.
+        bool timed_out = ! vblank && this->scheduler.get_cycle() >= this->frame_end_cycle;
+        if ((vblank || timed_out) && this->cpu.is_running())
+        {
+            if (vblank)
+                this->frame_end_cycle = this->scheduler.get_cycle() + FRAME_CYCLES;
+            else
+                this->frame_end_cycle += FRAME_CYCLES;
+            this->report_stats();
+            return true;
+        }
+    }
+    this->report_stats();
+    return false;
+}
+
+void GameBoy::report_stats()
+{
+    uint64_t cycle = this->scheduler.get_cycle();
+    if (cycle > this->reported_cycle)
+        RuntimeStats::add(this->stats.cycles, cycle - this->reported_cycle);
+    this->reported_cycle = cycle;
+
+    uint64_t instructions = this->cpu.get_instruction_count();
+    RuntimeStats::add(this->stats.instructions, instructions - this->reported_instructions);
+    this->reported_instructions = instructions;
+}
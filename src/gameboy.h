@@ -0,0 +1,148 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+#pragma once
+
+#include <memory>
+#include <atomic>
+#include <string>
+
+#include "timing.h"
+#include "runtime_stats.h"
+#include "ram.h"
+#include "scheduler.h"
+#include "interrupt_controller.h"
+#include "vpu.h"
+#include "timer.h"
+#include "joypad.h"
+#include "serial.h"
+#include "serial_buffer_sink.h"
+#include "apu.h"
+#include "cpu.h"
+#include "frame_hasher.h"
+
+// Bumped whenever the layout of any saved state changes
+#define SAVE_STATE_VERSION 2
+
+// State of all components. Plain data, so that saving and
+// loading is a copy of each component's fields
+struct gameboy_state_t {
+    cpu_state_t cpu;
+    ram_state_t ram;
+    scheduler_state_t scheduler;
+    interrupt_state_t interrupts;
+    vpu_state_t vpu;
+    timer_state_t timer;
+    joypad_state_t joypad;
+    serial_state_t serial;
+    apu_state_t apu;
+};
+
+// Header of save state files, followed by gameboy_state_t.
+// Values are stored in host byte order.
+struct save_state_header_t {
+    char magic[4];
+    uint32_t version;
+    uint32_t size;
+    uint64_t rom_hash;
+};
+
+// Single emulated machine, owning all of its components in one
+// allocation. Components only reference each other, so any number of
+// instances can run at once, each on its own thread.
+//
+// Lifecycle: an instance is created and loaded, then run_frame is
+// called repeatedly by a single thread until it returns false. Only
+// stop may be called from other threads. Once run_frame has returned
+// false, the instance can be destroyed.
+class GameBoy {
+public:
+    GameBoy();
+
+    // Load boot ROM and cartridge ROM, returning false if either cannot be read
+    bool load(const char *bios_path, const char *rom_path);
+
+    // Stop once the given CPU cycle is reached, capturing a
+    // screenshot first if a path is given
+    void set_stop_cycle(uint64_t cycle, const char *screenshot_path);
+    // Stop once hashes have passed or failed
+    void set_frame_hasher(FrameHasher *frame_hasher);
+    // Send serial output to sink, stopping once it has passed or failed
+    void set_serial_result(SerialBufferSink *serial_result);
+
+    // Run until the start of the next V-blank, or for one frame's
+    // worth of cycles whilst the LCD is off, returning false once
+    // emulation has stopped
+    bool run_frame();
+    // Request emulation to stop, from any thread
+    void stop();
+    bool is_running();
+    // Whether emulation was stopped by reaching the stop cycle
+    bool reached_stop_cycle();
+
+    // Hash of memory, for comparing the state of instances
+    uint64_t hash_memory();
+    // Hash of emulated state, for checking that runs match. The stop
+    // cycle, rendered pixels and audio waveforms are left out, as they
+    // depend on host options (frame skip, audio output), not emulation.
+    uint64_t hash_state();
+    // Hash of the loaded cartridge ROM file
+    uint64_t get_rom_hash() { return this->rom_hash; };
+
+    // Save or restore state of all components. States are loaded
+    // after load and before running, and the stop cycle of this
+    // instance is kept, rather than that of the saved state.
+    void save_state(gameboy_state_t &state);
+    void load_state(const gameboy_state_t &state);
+    // Save or restore state to file, returning false on error. Loading
+    // fails for states from other versions or other cartridge ROMs.
+    bool save_state_file(const char *path);
+    bool load_state_file(const char *path);
+
+    RuntimeStats *get_stats() { return &this->stats; };
+    RAM *get_ram() { return &this->ram; };
+    Scheduler *get_scheduler() { return &this->scheduler; };
+    VPU *get_vpu() { return &this->vpu; };
+    Joypad *get_joypad() { return &this->joypad; };
+    Serial *get_serial() { return &this->serial; };
+    Apu *get_apu() { return &this->apu; };
+    CPU *get_cpu() { return &this->cpu; };
+
+private:
+    GameBoy(const GameBoy&) = delete;
+    GameBoy& operator=(const GameBoy&) = delete;
+
+    // Host time is measured for one in this many iterations of the run
+    // loop. It is odd, so that samples fall in every PPU mode.
+    const unsigned int STATS_SAMPLE_INTERVAL = 17;
+
+    // Constructed in order, as later components reference earlier ones
+    RuntimeStats stats;
+    RAM ram;
+    Scheduler scheduler;
+    InterruptController interrupts;
+    VPU vpu;
+    Timer timer;
+    Joypad joypad;
+    Serial serial;
+    Apu apu;
+    CPU cpu;
+
+    uint64_t rom_hash;
+    std::string screenshot_path;
+    bool stop_cycle_reached;
+    FrameHasher *frame_hasher;
+    SerialBufferSink *serial_result;
+    std::atomic<bool> stop_requested;
+    // Cycle at which the frame ends, if no V-blank occurs first
+    uint64_t frame_end_cycle;
+
+    unsigned int stats_sample_count;
+    // Cycle and instruction count last added to stats
+    uint64_t reported_cycle;
+    uint64_t reported_instructions;
+    // Add cycles and instructions since last called to stats
+    void report_stats();
+};
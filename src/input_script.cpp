@@ -0,0 +1,69 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+#include "input_script.h"
+
+#include <iostream>
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+InputScript::InputScript()
+{
+    this->next_input = 0;
+}
+
+bool InputScript::load(const char *path)
+{
+    FILE *script_file = fopen(path, "r");
+    if (script_file == nullptr)
+    {
+        std::cout << "Unable to open input script: " << path << std::endl;
+        return false;
+    }
+
+    char line[256];
+    unsigned int line_number = 0;
+    bool valid = true;
+    while (valid && fgets(line, sizeof(line), script_file) != nullptr)
+    {
+        line_number ++;
+        char button_name[16];
+        char state[8];
+        script_input_t input;
+
+        // Skip comments and blank lines
+        if (line[0] == '#' || strspn(line, " \t\r\n") == strlen(line))
+            continue;
+
+        if (sscanf(line, "%" SCNu64 " %15s %7s", &input.frame_number, button_name, state) != 3 ||
+            (input.button = Joypad::get_button(button_name)) == JOYPAD_BUTTON_COUNT ||
+            (strcmp(state, "down") != 0 && strcmp(state, "up") != 0))
+        {
+            std::cout << "Invalid input on line " << line_number << " of " << path << std::endl;
+            valid = false;
+            break;
+        }
+        input.pressed = strcmp(state, "down") == 0;
+        this->inputs.push_back(input);
+    }
+    fclose(script_file);
+
+    // Inputs for the same frame are applied in file order
+    std::stable_sort(this->inputs.begin(), this->inputs.end(),
+        [](const script_input_t &a, const script_input_t &b) { return a.frame_number < b.frame_number; });
+    return valid;
+}
+
+void InputScript::apply(uint64_t frame_number, Joypad *joypad)
+{
+    while (this->next_input < this->inputs.size() &&
+           this->inputs[this->next_input].frame_number <= frame_number)
+    {
+        joypad->set_button(this->inputs[this->next_input].button, this->inputs[this->next_input].pressed);
+        this->next_input ++;
+    }
+}
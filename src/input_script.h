@@ -0,0 +1,37 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "joypad.h"
+
+// Button presses and releases read from a file, keyed by frame
+// number, so that games can be driven deterministically without
+// a display. Each line is '<frame> <button> <down|up>', e.g.
+//   120 start down
+//   122 start up
+// Blank lines and lines starting with '#' are ignored.
+class InputScript {
+public:
+    InputScript();
+
+    bool load(const char *path);
+
+    // Apply all inputs due by the given frame
+    void apply(uint64_t frame_number, Joypad *joypad);
+
+private:
+    struct script_input_t {
+        uint64_t frame_number;
+        JoypadButton button;
+        bool pressed;
+    };
+
+    std::vector<script_input_t> inputs;
+    unsigned int next_input;
+};
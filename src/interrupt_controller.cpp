@@ -0,0 +1,69 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+#include "interrupt_controller.h"
+
+InterruptController::InterruptController(RAM *ram)
+{
+    this->flags = 0;
+    this->enabled = 0;
+    this->pending = 0;
+
+    ram->register_io_handler(this->IF_ADDR, this);
+    ram->register_io_handler(this->IE_ADDR, this);
+}
+
+void InterruptController::update_pending()
+{
+    this->pending = this->flags & this->enabled & this->INTERRUPT_MASK;
+}
+
+void InterruptController::raise(InterruptType interrupt)
+{
+    this->flags |= (uint8_t)(1 << interrupt);
+    this->update_pending();
+}
+
+uint16_t InterruptController::acknowledge()
+{
+    // Lowest bit has the highest priority
+    unsigned int interrupt = 0;
+    while (! (this->pending & (1 << interrupt)))
+        interrupt ++;
+
+    this->flags &= (uint8_t)~(1 << interrupt);
+    this->update_pending();
+    return this->VECTOR_BASE + (this->VECTOR_SIZE * interrupt);
+}
+
+uint8_t InterruptController::io_read(uint16_t address, uint8_t stored_val)
+{
+    // Unused upper bits of IF read as 1
+    if (address == this->IF_ADDR)
+        return (uint8_t)(0xe0 | this->flags);
+    return this->enabled;
+}
+
+void InterruptController::io_write(uint16_t address, uint8_t val)
+{
+    if (address == this->IF_ADDR)
+        this->flags = val & this->INTERRUPT_MASK;
+    else
+        this->enabled = val;
+    this->update_pending();
+}
+
+void InterruptController::save_state(interrupt_state_t &state)
+{
+    state.flags = this->flags;
+    state.enabled = this->enabled;
+}
+
+void InterruptController::load_state(const interrupt_state_t &state)
+{
+    this->flags = state.flags;
+    this->enabled = state.enabled;
+    this->update_pending();
+}
@@ -0,0 +1,64 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+#pragma once
+
+#include <memory>
+#include "ram.h"
+#include "io_handler.h"
+
+// Interrupt sources, by bit in IF/IE, in priority order
+enum InterruptType {
+    INTERRUPT_VBLANK = 0,
+    INTERRUPT_STAT = 1,
+    INTERRUPT_TIMER = 2,
+    INTERRUPT_SERIAL = 3,
+    INTERRUPT_JOYPAD = 4
+};
+
+// Saved state of interrupt registers
+struct interrupt_state_t {
+    uint8_t flags;
+    uint8_t enabled;
+};
+
+// Interrupt flag (IF) and enable (IE) registers.
+// The set of interrupts that are both requested and enabled is
+// cached whenever either register changes, so that the CPU only
+// needs to check a single value between instructions.
+class InterruptController : public IoHandler {
+public:
+    InterruptController(RAM *ram);
+
+    // Request interrupt, setting its IF bit
+    void raise(InterruptType interrupt);
+
+    // Whether any requested interrupt is enabled
+    bool has_pending() {
+        return this->pending != 0;
+    };
+    // Clear highest priority pending interrupt, returning its vector address
+    uint16_t acknowledge();
+
+    uint8_t io_read(uint16_t address, uint8_t stored_val);
+    void io_write(uint16_t address, uint8_t val);
+
+    void save_state(interrupt_state_t &state);
+    void load_state(const interrupt_state_t &state);
+
+private:
+    const uint16_t IF_ADDR = 0xff0f;
+    const uint16_t IE_ADDR = 0xffff;
+    const uint8_t INTERRUPT_MASK = 0x1f;
+    // Vectors start at 0x40, 8 bytes apart
+    const uint16_t VECTOR_BASE = 0x0040;
+    const uint16_t VECTOR_SIZE = 0x0008;
+
+    uint8_t flags;
+    uint8_t enabled;
+    uint8_t pending;
+
+    void update_pending();
+};
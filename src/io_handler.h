@@ -0,0 +1,23 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+#pragma once
+
+#include <memory>
+
+// Peripheral which handles accesses to memory-mapped IO registers
+// (0xff00-0xffff), allowing register values to be derived from
+// peripheral state when read, rather than being updated in RAM
+// on every clock cycle.
+class IoHandler {
+public:
+    virtual ~IoHandler() {};
+
+    // Obtain value of register, being passed the last value
+    // that was written to the register.
+    virtual uint8_t io_read(uint16_t address, uint8_t stored_val) = 0;
+    // Called after value has been written to the register.
+    virtual void io_write(uint16_t address, uint8_t val) = 0;
+};
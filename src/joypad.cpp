@@ -0,0 +1,94 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+#include "joypad.h"
+
+#include <string.h>
+
+Joypad::Joypad(RAM *ram, InterruptController *interrupts)
+{
+    this->interrupts = interrupts;
+    this->listener = nullptr;
+    this->pressed = 0;
+    this->select = this->SELECT_MASK;
+    this->low_lines = 0;
+
+    ram->register_io_handler(this->P1_ADDR, this);
+}
+
+JoypadButton Joypad::get_button(const char *name)
+{
+    const char *names[JOYPAD_BUTTON_COUNT] = {"right", "left", "up", "down", "a", "b", "select", "start"};
+    for (unsigned int button = 0; button < JOYPAD_BUTTON_COUNT; button ++)
+        if (strcmp(name, names[button]) == 0)
+            return (JoypadButton)button;
+    return JOYPAD_BUTTON_COUNT;
+}
+
+void Joypad::set_button(JoypadButton button, bool pressed)
+{
+    if (pressed)
+        this->set_pressed(this->pressed | (uint8_t)(1 << button));
+    else
+        this->set_pressed(this->pressed & (uint8_t)~(1 << button));
+}
+
+void Joypad::set_pressed(uint8_t pressed)
+{
+    if (pressed == this->pressed)
+        return;
+    this->pressed = pressed;
+    this->update_lines();
+    if (this->listener != nullptr)
+        this->listener->buttons_changed(this->pressed);
+}
+
+void Joypad::set_listener(JoypadListener *listener)
+{
+    this->listener = listener;
+}
+
+uint8_t Joypad::get_low_lines()
+{
+    uint8_t lines = 0;
+    if (! (this->select & this->SELECT_DIRECTIONS))
+        lines |= this->pressed & 0x0f;
+    if (! (this->select & this->SELECT_ACTIONS))
+        lines |= this->pressed >> 4;
+    return lines;
+}
+
+void Joypad::update_lines()
+{
+    uint8_t new_low_lines = this->get_low_lines();
+    if (new_low_lines & ~this->low_lines)
+        this->interrupts->raise(InterruptType::INTERRUPT_JOYPAD);
+    this->low_lines = new_low_lines;
+}
+
+uint8_t Joypad::io_read(uint16_t address, uint8_t stored_val)
+{
+    return this->UNUSED_BITS | this->select | (uint8_t)(~this->low_lines & 0x0f);
+}
+
+void Joypad::io_write(uint16_t address, uint8_t val)
+{
+    this->select = val & this->SELECT_MASK;
+    this->update_lines();
+}
+
+void Joypad::save_state(joypad_state_t &state)
+{
+    state.pressed = this->pressed;
+    state.select = this->select;
+    state.low_lines = this->low_lines;
+}
+
+void Joypad::load_state(const joypad_state_t &state)
+{
+    this->pressed = state.pressed;
+    this->select = state.select;
+    this->low_lines = state.low_lines;
+}
@@ -0,0 +1,90 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+#pragma once
+
+#include <memory>
+#include "ram.h"
+#include "io_handler.h"
+#include "interrupt_controller.h"
+
+// Buttons, by bit of the joypad state. Directions are read through
+// P1 bits 0-3 when P14 is low, and actions when P15 is low.
+enum JoypadButton {
+    JOYPAD_RIGHT = 0,
+    JOYPAD_LEFT = 1,
+    JOYPAD_UP = 2,
+    JOYPAD_DOWN = 3,
+    JOYPAD_A = 4,
+    JOYPAD_B = 5,
+    JOYPAD_SELECT = 6,
+    JOYPAD_START = 7,
+    JOYPAD_BUTTON_COUNT = 8
+};
+
+// Saved state of joypad register and buttons
+struct joypad_state_t {
+    uint8_t pressed;
+    uint8_t select;
+    uint8_t low_lines;
+};
+
+// Receives each change of button state, e.g. to record input
+class JoypadListener {
+public:
+    virtual ~JoypadListener() {};
+
+    // Called after buttons change, with the new pressed bits
+    virtual void buttons_changed(uint8_t pressed) = 0;
+};
+
+// Joypad register (P1, 0xff00).
+// Button state is set from the emulation thread, between instructions,
+// and raises the joypad interrupt when a selected input line goes low.
+class Joypad : public IoHandler {
+public:
+    Joypad(RAM *ram, InterruptController *interrupts);
+
+    void set_button(JoypadButton button, bool pressed);
+    // Bit set for each pressed button, by JoypadButton
+    uint8_t get_pressed() {
+        return this->pressed;
+    };
+    void set_pressed(uint8_t pressed);
+    // Notify listener of button changes, nullptr for none
+    void set_listener(JoypadListener *listener);
+
+    uint8_t io_read(uint16_t address, uint8_t stored_val);
+    void io_write(uint16_t address, uint8_t val);
+
+    void save_state(joypad_state_t &state);
+    void load_state(const joypad_state_t &state);
+
+    // Convert button name (e.g. 'a', 'start', 'up') to button,
+    // returning JOYPAD_BUTTON_COUNT if not recognised
+    static JoypadButton get_button(const char *name);
+
+private:
+    const uint16_t P1_ADDR = 0xff00;
+    const uint8_t SELECT_DIRECTIONS = 0x10;
+    const uint8_t SELECT_ACTIONS = 0x20;
+    const uint8_t SELECT_MASK = 0x30;
+    // Bits 6 and 7 are unused and always read as 1
+    const uint8_t UNUSED_BITS = 0xc0;
+
+    InterruptController *interrupts;
+    JoypadListener *listener;
+
+    // Bit set for each pressed button
+    uint8_t pressed;
+    // P14/P15 select bits, as written (0 selects)
+    uint8_t select;
+    // Input lines currently pulled low, by selected pressed buttons
+    uint8_t low_lines;
+
+    uint8_t get_low_lines();
+    // Recalculate input lines, raising interrupt on high to low transition
+    void update_lines();
+};
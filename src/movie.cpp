@@ -0,0 +1,174 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+#include "movie.h"
+
+#include <iostream>
+#include <fstream>
+#include <string.h>
+
+Movie::Movie() :
+    initial_state(new gameboy_state_t)
+{
+    this->gameboy = nullptr;
+    this->replaying = false;
+    this->diverged = false;
+    this->frame = 0;
+    this->next_input = 0;
+    memset(&this->header, 0, sizeof(this->header));
+}
+
+void Movie::start_recording(GameBoy *gameboy, unsigned int checkpoint_interval)
+{
+    this->gameboy = gameboy;
+    this->replaying = false;
+    this->diverged = false;
+    this->frame = 0;
+    this->inputs.clear();
+    this->checkpoints.clear();
+
+    memset(&this->header, 0, sizeof(this->header));
+    memcpy(this->header.magic, "GBMV", sizeof(this->header.magic));
+    this->header.version = MOVIE_VERSION;
+    this->header.rom_hash = gameboy->get_rom_hash();
+    this->header.state_size = sizeof(gameboy_state_t);
+    this->header.checkpoint_interval = checkpoint_interval;
+    gameboy->save_state(*this->initial_state);
+    gameboy->get_joypad()->set_listener(this);
+}
+
+bool Movie::finish_recording(const char *path)
+{
+    this->gameboy->get_joypad()->set_listener(nullptr);
+    this->header.frame_count = this->frame;
+    this->header.input_count = this->inputs.size();
+    this->header.checkpoint_count = this->checkpoints.size();
+    this->header.final_cycle = this->gameboy->get_scheduler()->get_cycle();
+    this->header.final_hash = this->gameboy->hash_state();
+
+    std::ofstream movie_file(path, std::ios::binary | std::ios::trunc);
+    movie_file.write((const char*)&this->header, sizeof(this->header));
+    movie_file.write((const char*)this->initial_state.get(), sizeof(gameboy_state_t));
+    movie_file.write((const char*)this->inputs.data(), this->inputs.size() * sizeof(movie_input_t));
+    movie_file.write((const char*)this->checkpoints.data(), this->checkpoints.size() * sizeof(uint64_t));
+    if (! movie_file.good())
+    {
+        std::cout << "Unable to write movie: " << path << std::endl;
+        return false;
+    }
+    std::cout << "Recorded movie: " << std::dec << this->frame << " frames, "
+              << this->inputs.size() << " inputs, " << this->checkpoints.size() << " checkpoints" << std::endl;
+    return true;
+}
+
+bool Movie::load(const char *path)
+{
+    std::ifstream movie_file(path, std::ios::binary);
+    movie_file.read((char*)&this->header, sizeof(this->header));
+    if (! movie_file.good() || memcmp(this->header.magic, "GBMV", sizeof(this->header.magic)) != 0)
+    {
+        std::cout << "Unable to read movie: " << path << std::endl;
+        return false;
+    }
+    if (this->header.version != MOVIE_VERSION || this->header.state_size != sizeof(gameboy_state_t))
+    {
+        std::cout << "Movie is from an incompatible version: " << path << std::endl;
+        return false;
+    }
+
+    this->inputs.resize(this->header.input_count);
+    this->checkpoints.resize(this->header.checkpoint_count);
+    movie_file.read((char*)this->initial_state.get(), sizeof(gameboy_state_t));
+    movie_file.read((char*)this->inputs.data(), this->inputs.size() * sizeof(movie_input_t));
+    movie_file.read((char*)this->checkpoints.data(), this->checkpoints.size() * sizeof(uint64_t));
+    if (! movie_file.good())
+    {
+        std::cout << "Movie is truncated: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool Movie::start_replay(GameBoy *gameboy)
+{
+    if (this->header.rom_hash != gameboy->get_rom_hash())
+    {
+        std::cout << "Movie is for a different ROM" << std::endl;
+        return false;
+    }
+
+    this->gameboy = gameboy;
+    this->replaying = true;
+    this->diverged = false;
+    this->frame = 0;
+    this->next_input = 0;
+    gameboy->load_state(*this->initial_state);
+    gameboy->set_stop_cycle(this->header.final_cycle, nullptr);
+    return true;
+}
+
+bool Movie::finish_replay()
+{
+    if (this->diverged)
+        return false;
+
+    if (this->gameboy->get_scheduler()->get_cycle() != this->header.final_cycle ||
+        this->frame != this->header.frame_count || this->next_input != this->inputs.size())
+        this->report_divergence("replay stopped before the end of the movie");
+    else if (this->gameboy->hash_state() != this->header.final_hash)
+        this->report_divergence("final state hash differs");
+    else
+        std::cout << "Movie replay matched: " << std::dec << this->frame << " frames, "
+                  << this->checkpoints.size() << " checkpoints" << std::endl;
+    return ! this->diverged;
+}
+
+void Movie::start_frame()
+{
+    if (this->replaying)
+    {
+        if (this->frame >= this->header.frame_count)
+        {
+            this->report_divergence("replay ran past the end of the movie");
+            return;
+        }
+        // Changes are applied one at a time, raising the
+        // same joypad interrupts as when recorded
+        while (this->next_input < this->inputs.size() && this->inputs[this->next_input].frame <= this->frame)
+            this->gameboy->get_joypad()->set_pressed(this->inputs[this->next_input ++].pressed);
+    }
+    this->frame ++;
+}
+
+void Movie::buttons_changed(uint8_t pressed)
+{
+    movie_input_t input;
+    memset(&input, 0, sizeof(input));
+    input.frame = this->frame;
+    input.pressed = pressed;
+    this->inputs.push_back(input);
+}
+
+bool Movie::end_frame()
+{
+    unsigned int interval = this->header.checkpoint_interval;
+    if (this->diverged || interval == 0 || this->frame % interval != 0)
+        return ! this->diverged;
+
+    uint64_t hash = this->gameboy->hash_state();
+    unsigned int checkpoint = this->frame / interval - 1;
+    if (! this->replaying)
+        this->checkpoints.push_back(hash);
+    else if (checkpoint >= this->checkpoints.size() || this->checkpoints[checkpoint] != hash)
+        this->report_divergence("state hash differs from checkpoint");
+    return ! this->diverged;
+}
+
+void Movie::report_divergence(const char *reason)
+{
+    std::cout << "Movie replay diverged at frame " << std::dec << this->frame << ": " << reason << std::endl;
+    this->diverged = true;
+    this->gameboy->stop();
+}
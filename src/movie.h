@@ -0,0 +1,101 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+#include "gameboy.h"
+
+// Bumped whenever the movie file layout changes
+#define MOVIE_VERSION 2
+// Frames between state hash checkpoints, unless set when recording
+#define MOVIE_DEFAULT_CHECKPOINT_INTERVAL 60
+
+// Header of movie files, followed by the initial gameboy_state_t, each
+// change of joypad buttons (movie_input_t) and the state hash of each
+// checkpoint. Values are stored in host byte order.
+struct movie_header_t {
+    char magic[4];
+    uint32_t version;
+    uint64_t rom_hash;
+    uint32_t state_size;
+    // Frames between state hash checkpoints, 0 for none
+    uint32_t checkpoint_interval;
+    uint32_t frame_count;
+    uint32_t input_count;
+    uint32_t checkpoint_count;
+    // Cycle and state hash at which recording stopped
+    uint64_t final_cycle;
+    uint64_t final_hash;
+};
+
+// Joypad buttons pressed, from before the given frame starts. Each
+// change is kept, rather than the buttons for each frame, as changes
+// between frames can raise the joypad interrupt.
+struct movie_input_t {
+    uint32_t frame;
+    uint8_t pressed;
+};
+
+// Records joypad input between frames, from a saved initial state, so
+// that a run can be replayed exactly. As emulation is deterministic,
+// only input needs to be recorded. State hashes are checked every
+// checkpoint interval and once the replay reaches the cycle that
+// recording stopped at, so replays fail at the first divergence.
+//
+// For each frame, start_frame is called before running it and
+// end_frame after it has completed.
+class Movie : public JoypadListener {
+public:
+    Movie();
+
+    // Start recording from the current state
+    void start_recording(GameBoy *gameboy, unsigned int checkpoint_interval);
+    // Stop recording at the current cycle, and write movie to file
+    bool finish_recording(const char *path);
+
+    // Load movie, then start replay, loading its initial state and
+    // stopping emulation at the cycle recording stopped at
+    bool load(const char *path);
+    bool start_replay(GameBoy *gameboy);
+    // Check final state once the replay has stopped, returning
+    // whether the whole replay matched
+    bool finish_replay();
+
+    // Record or apply input for the next frame
+    void start_frame();
+    // Record or check state hash, if this frame is a checkpoint,
+    // returning false (and stopping emulation) if the replay diverged
+    bool end_frame();
+
+    // Record change of buttons before the next frame
+    void buttons_changed(uint8_t pressed);
+
+    bool has_diverged() {
+        return this->diverged;
+    };
+    unsigned int get_frame_count() {
+        return this->header.frame_count;
+    };
+
+private:
+    GameBoy *gameboy;
+    bool replaying;
+    bool diverged;
+    // Frames started so far
+    unsigned int frame;
+    // Next input to apply, whilst replaying
+    unsigned int next_input;
+
+    movie_header_t header;
+    std::unique_ptr<gameboy_state_t> initial_state;
+    std::vector<movie_input_t> inputs;
+    std::vector<uint64_t> checkpoints;
+
+    void report_divergence(const char *reason);
+};
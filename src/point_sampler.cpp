@@ -0,0 +1,49 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+#include "point_sampler.h"
+
+PointSampler::PointSampler(AudioRing *ring, unsigned int sample_rate) : RingOutput(ring, sample_rate)
+{
+    this->sample_count = 0;
+    this->base_cycle = 0;
+    this->next_sample_cycle = 0;
+    this->cycles_per_sample = (double)CPU_CLOCK_HZ / sample_rate;
+    this->level_left = 0;
+    this->level_right = 0;
+}
+
+void PointSampler::set_level(uint64_t cycle, int16_t left, int16_t right)
+{
+    // Samples before the change use the previous level
+    this->run_until(cycle);
+    this->level_left = left;
+    this->level_right = right;
+}
+
+void PointSampler::run_until(uint64_t cycle)
+{
+    while (this->next_sample_cycle < cycle)
+    {
+        this->push_sample(this->level_left, this->level_right);
+        this->sample_count ++;
+        this->next_sample_cycle = this->base_cycle + (uint64_t)(this->sample_count * this->cycles_per_sample);
+    }
+}
+
+void PointSampler::set_rate_adjustment(double adjustment)
+{
+    // Restart counting from the next sample, so it does not move
+    this->base_cycle = this->next_sample_cycle;
+    this->sample_count = 0;
+    this->cycles_per_sample = ((double)CPU_CLOCK_HZ / this->sample_rate) * adjustment;
+}
+
+void PointSampler::set_cycle(uint64_t cycle)
+{
+    this->base_cycle = cycle;
+    this->next_sample_cycle = cycle;
+    this->sample_count = 0;
+}
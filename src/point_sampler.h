@@ -0,0 +1,33 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+#pragma once
+
+#include <memory>
+
+#include "ring_output.h"
+
+// Samples the APU output level at each host sample time. This is the
+// cheapest output, but aliases high frequency waveforms.
+class PointSampler : public RingOutput {
+public:
+    PointSampler(AudioRing *ring, unsigned int sample_rate);
+
+    void set_level(uint64_t cycle, int16_t left, int16_t right);
+    void run_until(uint64_t cycle);
+    void set_cycle(uint64_t cycle);
+    void set_rate_adjustment(double adjustment);
+
+private:
+    // Number of samples produced since the rate was last set, from
+    // which the cycle of the next sample is derived
+    uint64_t sample_count;
+    uint64_t base_cycle;
+    uint64_t next_sample_cycle;
+    double cycles_per_sample;
+
+    float level_left;
+    float level_right;
+};
@@ -17,17 +17,22 @@ RAM::RAM() {
     // Initialise memory to 0.
     // @TODO This is NOT what is done on the real console -
     // internal and high RAM should be left as random values.
-    for (int me = 0; me < this->memory_max; me ++)
+    for (unsigned int me = 0; me < this->memory_max; me ++)
         this->memory[me] = 0;
-        
+
+    for (unsigned int io_itx = 0; io_itx < IO_REGISTER_COUNT; io_itx ++)
+        this->io_handlers[io_itx] = nullptr;
+
     this->boot_rom_swapped = false;
 }
 
 uint8_t RAM::get_val(uint16_t address) {
     uint8_t val;
-    if (address > this->memory_max)
+    if (address >= this->memory_max)
         std::cout << std::hex << "ERROR: Got from outside RAM (" << address << "): " << std::endl;
     memcpy(&val, &this->memory[address], 1);
+    if (address >= this->IO_REGISTER_START && this->io_handlers[address - this->IO_REGISTER_START] != nullptr)
+        val = this->io_handlers[address - this->IO_REGISTER_START]->io_read(address, val);
     if (DEBUG)
         std::cout << std::hex << "Got from RAM (" << address << "): "  << (int)val << std::endl;
     return val;
@@ -104,11 +109,23 @@ void RAM::v_set(uint16_t address, uint8_t val) {
     if (address == this->ROM_SWAP_ADDRESS && val)
         this->swap_boot_rom();
 
+    if (address == this->OAM_DMA_ADDR)
+        this->oam_dma_transfer(val);
+
     if (DEBUG)
         std::cout << std::hex << "Set RAM value (" << address << "): "  << (int)val << std::endl;
     this->memory[address] = val;
+
+    if (address >= this->IO_REGISTER_START && this->io_handlers[address - this->IO_REGISTER_START] != nullptr)
+        this->io_handlers[address - this->IO_REGISTER_START]->io_write(address, val);
 }
 uint8_t RAM::dec(uint16_t address) {
+    if (address >= this->IO_REGISTER_START && this->io_handlers[address - this->IO_REGISTER_START] != nullptr)
+    {
+        uint8_t val = this->get_val(address) - 1;
+        this->v_set(address, val);
+        return val;
+    }
     this->memory[address] --;
     return this->memory[address];
 }
@@ -124,10 +141,19 @@ uint8_t RAM::inc(uint16_t address) {
         return this->v_inc(address);
 }
 uint8_t RAM::v_inc(uint16_t address) {
+    if (address >= this->IO_REGISTER_START && this->io_handlers[address - this->IO_REGISTER_START] != nullptr)
+    {
+        uint8_t val = this->get_val(address) + 1;
+        this->v_set(address, val);
+        return val;
+    }
     this->memory[address] ++;
     return this->memory[address];
 }
 
+void RAM::register_io_handler(uint16_t address, IoHandler *handler) {
+    this->io_handlers[address - this->IO_REGISTER_START] = handler;
+}
 
 uint8_t RAM::get_ram_bit(uint16_t address, unsigned int bit_shift) {
     return ((this->get_val(address) & (1U  << bit_shift)) >> bit_shift);
@@ -211,3 +237,28 @@ void RAM::swap_boot_rom() {
         this->memory_boot_swap[itx] = temp;
     }
 }
+
+void RAM::oam_dma_transfer(uint8_t source_high) {
+    // Copy 0xa0 bytes from XX00-XX9F into OAM, where
+    // XX is the value written to the DMA register
+    uint16_t source = (uint16_t)source_high << 8;
+    if (DEBUG)
+        std::cout << std::hex << "OAM DMA transfer from: " << (int)source << std::endl;
+
+    for (unsigned int itx = 0; itx < this->OAM_SIZE; itx ++)
+        this->memory[this->OAM_ADDRESS + itx] = this->memory[source + itx];
+}
+
+void RAM::save_state(ram_state_t &state) {
+    // IO registers are copied as stored, without IO handlers,
+    // which save their own state
+    memcpy(state.memory, this->memory, sizeof(state.memory));
+    memcpy(state.memory_boot_swap, this->memory_boot_swap, sizeof(state.memory_boot_swap));
+    state.boot_rom_swapped = this->boot_rom_swapped;
+}
+
+void RAM::load_state(const ram_state_t &state) {
+    memcpy(this->memory, state.memory, sizeof(this->memory));
+    memcpy(this->memory_boot_swap, state.memory_boot_swap, sizeof(this->memory_boot_swap));
+    this->boot_rom_swapped = state.boot_rom_swapped;
+}
@@ -8,11 +8,22 @@
 #include <memory>
 #include "helper.h"
 #include "ram_subset.h"
+#include "io_handler.h"
 
 class TestRunner;
 
 // 0x10000
-#define MAX_MEM_SIZE 65535
+#define MAX_MEM_SIZE 65536
+// IO registers, high RAM and interrupt enable register (0xff00-0xffff)
+#define IO_REGISTER_COUNT 0x100
+
+// Saved memory map, including cartridge ROM and the boot ROM,
+// or the cartridge bytes it replaces, whilst not swapped out
+struct ram_state_t {
+    uint8_t memory[MAX_MEM_SIZE];
+    uint8_t memory_boot_swap[256];
+    bool boot_rom_swapped;
+};
 
 class RAM {
     friend TestRunner;
@@ -40,8 +51,12 @@ public:
     RamSubset get_high_ram();
     void load_bios(arguments_t *arguments);
     void load_rom(arguments_t *arguments);
+    void save_state(ram_state_t &state);
+    void load_state(const ram_state_t &state);
     bool boot_rom_swapped;
 
+    void register_io_handler(uint16_t address, IoHandler *handler);
+
     uint8_t get_ram_bit(uint16_t address, unsigned int bit_shift);
     uint8_t set_ram_bit(uint16_t address, uint8_t bit_shift, unsigned int val);
 
@@ -52,6 +67,10 @@ public:
     const uint16_t LCDC_SCX          = (uint16_t)0xff43; // Background Scroll X
     const uint16_t LCDC_LY_ADDR      = (uint16_t)0xff44; // Current line draw iterator
     const uint16_t LCDC_LYC_ADDR     = (uint16_t)0xff45; // Custom location for interrupt if LY equals this
+    const uint16_t OAM_DMA_ADDR      = (uint16_t)0xff46; // OAM DMA transfer source address (high byte)
+    const uint16_t LCDC_BGP_ADDR     = (uint16_t)0xff47; // Background palette data
+    const uint16_t LCDC_OBP0_ADDR    = (uint16_t)0xff48; // Object palette 0 data
+    const uint16_t LCDC_OBP1_ADDR    = (uint16_t)0xff49; // Object palette 1 data
     const uint16_t LCDC_WY_ADDR      = (uint16_t)0xff4a; // Window y position
     const uint16_t LCDC_WX_ADDR      = (uint16_t)0xff4b; // Window x position
     
@@ -66,6 +85,13 @@ private:
     uint16_t ROM_SWAP_ADDRESS = (uint16_t)0xff50;
     unsigned int BOOT_ROM_SIZE = 256;
     void swap_boot_rom();
+    void oam_dma_transfer(uint8_t source_high);
+    uint16_t OAM_ADDRESS = (uint16_t)0xfe00;
+    unsigned int OAM_SIZE = 0xa0;
     uint8_t memory_boot_swap[256];
-    uint16_t memory_max = MAX_MEM_SIZE;
+    unsigned int memory_max = MAX_MEM_SIZE;
+
+    // Peripherals handling IO register accesses, indexed from 0xff00
+    const uint16_t IO_REGISTER_START = (uint16_t)0xff00;
+    IoHandler *io_handlers[IO_REGISTER_COUNT];
 };
@@ -0,0 +1,188 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+#include "rewind_buffer.h"
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string.h>
+
+// Lengths are stored 7 bits per byte, lowest first, with the
+// top bit set on all but the last byte
+static void write_length(std::vector<uint8_t> &data, size_t length)
+{
+    while (length >= 0x80)
+    {
+        data.push_back((uint8_t)(length | 0x80));
+        length >>= 7;
+    }
+    data.push_back((uint8_t)length);
+}
+
+static size_t read_length(const std::vector<uint8_t> &data, size_t &position)
+{
+    size_t length = 0;
+    unsigned int shift = 0;
+    uint8_t val;
+    do
+    {
+        val = data[position++];
+        length |= (size_t)(val & 0x7f) << shift;
+        shift += 7;
+    } while (val & 0x80);
+    return length;
+}
+
+RewindBuffer::RewindBuffer(GameBoy *gameboy, unsigned int interval, size_t budget) :
+    newest(new gameboy_state_t),
+    scratch(new gameboy_state_t)
+{
+    this->gameboy = gameboy;
+    this->interval = interval ? interval : 1;
+    this->budget = budget;
+    this->frames_since_capture = 0;
+    this->has_newest = false;
+    this->delta_bytes = 0;
+    this->total_deltas = 0;
+    this->total_delta_bytes = 0;
+
+    // Newest and scratch snapshots are always kept in full
+    if (this->budget < REWIND_FULL_BYTES)
+        std::cout << "Rewind budget of " << this->budget << " bytes is below the "
+                  << REWIND_FULL_BYTES << " bytes used by full snapshots, so no history will be kept" << std::endl;
+}
+
+void RewindBuffer::frame()
+{
+    if (++ this->frames_since_capture >= this->interval)
+        this->capture();
+}
+
+void RewindBuffer::capture()
+{
+    this->frames_since_capture = 0;
+    this->gameboy->save_state(*this->scratch);
+    if (this->has_newest)
+    {
+        std::vector<uint8_t> delta;
+        RewindBuffer::encode_delta((const uint8_t*)this->newest.get(), (const uint8_t*)this->scratch.get(), sizeof(gameboy_state_t), delta);
+        this->delta_bytes += delta.size();
+        this->total_deltas ++;
+        this->total_delta_bytes += delta.size();
+        this->deltas.push_back(std::move(delta));
+    }
+    std::swap(this->newest, this->scratch);
+    this->has_newest = true;
+
+    // Full snapshots count against the budget, along with the deltas
+    while (! this->deltas.empty() && REWIND_FULL_BYTES + this->delta_bytes > this->budget)
+    {
+        this->delta_bytes -= this->deltas.front().size();
+        this->deltas.pop_front();
+    }
+}
+
+bool RewindBuffer::rewind()
+{
+    if (! this->has_newest)
+        return false;
+
+    bool stepped = ! this->deltas.empty();
+    if (stepped)
+    {
+        RewindBuffer::apply_delta(this->deltas.back(), (uint8_t*)this->newest.get(), sizeof(gameboy_state_t));
+        this->delta_bytes -= this->deltas.back().size();
+        this->deltas.pop_back();
+    }
+    this->gameboy->load_state(*this->newest);
+    this->frames_since_capture = 0;
+    return stepped;
+}
+
+unsigned int RewindBuffer::get_snapshot_count()
+{
+    return this->deltas.size();
+}
+
+size_t RewindBuffer::get_bytes()
+{
+    return this->delta_bytes + REWIND_FULL_BYTES;
+}
+
+double RewindBuffer::get_seconds()
+{
+    return (double)this->deltas.size() * this->interval * FRAME_CYCLES / CPU_CLOCK_HZ;
+}
+
+double RewindBuffer::get_bytes_per_second()
+{
+    if (this->total_deltas == 0)
+        return 0;
+    return (double)this->total_delta_bytes / this->total_deltas * CPU_CLOCK_HZ / FRAME_CYCLES / this->interval;
+}
+
+void RewindBuffer::print_stats()
+{
+    std::ostringstream text;
+    text << std::fixed << std::setprecision(1)
+         << "Rewind: " << this->get_snapshot_count() << " snapshots, "
+         << this->get_seconds() << "s, "
+         << (this->get_bytes() / 1024.0) << "KB, "
+         << (this->get_bytes_per_second() / 1024.0) << "KB per second (snapshot every "
+         << this->interval << " frames)" << std::endl;
+    std::cout << text.str() << std::flush;
+}
+
+void RewindBuffer::encode_delta(const uint8_t *previous, const uint8_t *next, size_t size, std::vector<uint8_t> &delta)
+{
+    // Alternating runs of unchanged and changed bytes: the unchanged
+    // length, then the changed length and XOR of each changed byte
+    size_t position = 0;
+    while (position < size)
+    {
+        size_t unchanged_start = position;
+        uint64_t previous_word, next_word;
+        while (position + sizeof(uint64_t) <= size)
+        {
+            memcpy(&previous_word, previous + position, sizeof(uint64_t));
+            memcpy(&next_word, next + position, sizeof(uint64_t));
+            if (previous_word != next_word)
+                break;
+            position += sizeof(uint64_t);
+        }
+        while (position < size && previous[position] == next[position])
+            position ++;
+        write_length(delta, position - unchanged_start);
+
+        size_t changed_end = position;
+        while (changed_end < size)
+        {
+            size_t unchanged = 0;
+            while (unchanged < REWIND_MIN_UNCHANGED_RUN && changed_end + unchanged < size &&
+                   previous[changed_end + unchanged] == next[changed_end + unchanged])
+                unchanged ++;
+            if (unchanged == REWIND_MIN_UNCHANGED_RUN || changed_end + unchanged == size)
+                break;
+            changed_end += unchanged + 1;
+        }
+        write_length(delta, changed_end - position);
+        for (; position < changed_end; position ++)
+            delta.push_back(previous[position] ^ next[position]);
+    }
+}
+
+void RewindBuffer::apply_delta(const std::vector<uint8_t> &delta, uint8_t *data, size_t size)
+{
+    size_t delta_position = 0;
+    size_t position = 0;
+    while (delta_position < delta.size() && position < size)
+    {
+        position += read_length(delta, delta_position);
+        size_t changed = read_length(delta, delta_position);
+        for (size_t itx = 0; itx < changed; itx ++)
+            data[position ++] ^= delta[delta_position ++];
+    }
+}
@@ -0,0 +1,78 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <deque>
+#include <cstdint>
+#include <cstddef>
+
+#include "timing.h"
+#include "gameboy.h"
+
+#define REWIND_DEFAULT_INTERVAL 4
+// Changed runs continue over unchanged runs shorter than this,
+// as each run costs 2 bytes or more of lengths
+#define REWIND_MIN_UNCHANGED_RUN 4
+// Memory used by the newest and scratch snapshots, which are
+// kept in full and count against the budget
+#define REWIND_FULL_BYTES (2 * sizeof(gameboy_state_t))
+
+// Keeps a history of save states, taken every N frames, so that
+// emulation can be stepped backwards.
+//
+// Only the newest snapshot is kept in full. Each older snapshot is
+// stored as the XOR of it and the snapshot after it, which is mostly
+// zero bytes, compressed by run length. Stepping back applies the
+// newest delta to the newest snapshot. The oldest deltas are dropped
+// once the history and full snapshots exceed the memory budget.
+class RewindBuffer {
+public:
+    RewindBuffer(GameBoy *gameboy, unsigned int interval, size_t budget);
+
+    // Called once per emulated frame, taking a snapshot every interval
+    void frame();
+    // Take a snapshot of the current state
+    void capture();
+    // Restore the snapshot before the newest, returning false if
+    // there is none, in which case the newest is restored
+    bool rewind();
+
+    // Number of snapshots that can be stepped back to
+    unsigned int get_snapshot_count();
+    // Memory used by snapshots
+    size_t get_bytes();
+    // Emulated seconds of history
+    double get_seconds();
+    // Memory used per emulated second of history
+    double get_bytes_per_second();
+    void print_stats();
+
+    // Encode XOR of two buffers, as alternating unchanged and changed
+    // run lengths, with the XOR of each changed byte
+    static void encode_delta(const uint8_t *previous, const uint8_t *next, size_t size, std::vector<uint8_t> &delta);
+    // XOR delta into data, turning either buffer into the other
+    static void apply_delta(const std::vector<uint8_t> &delta, uint8_t *data, size_t size);
+
+private:
+
+    GameBoy *gameboy;
+    unsigned int interval;
+    size_t budget;
+    unsigned int frames_since_capture;
+
+    // Newest snapshot, and the one being captured
+    std::unique_ptr<gameboy_state_t> newest;
+    std::unique_ptr<gameboy_state_t> scratch;
+    bool has_newest;
+    // Compressed deltas, oldest first
+    std::deque<std::vector<uint8_t> > deltas;
+    size_t delta_bytes;
+    // Totals for all deltas compressed, including those since dropped
+    uint64_t total_deltas;
+    uint64_t total_delta_bytes;
+};
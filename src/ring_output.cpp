@@ -0,0 +1,54 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+#include "ring_output.h"
+
+#include <cmath>
+#include <algorithm>
+#include <thread>
+
+RingOutput::RingOutput(AudioRing *ring, unsigned int sample_rate)
+{
+    this->ring = ring;
+    this->sample_rate = sample_rate;
+    this->blocking = false;
+    this->dropped_frames = 0;
+    this->capacitor_left = 0;
+    this->capacitor_right = 0;
+    // Capacitor discharges by a factor of 0.999958 per cycle
+    this->charge_factor = (float)pow(0.999958, (double)CPU_CLOCK_HZ / sample_rate);
+}
+
+void RingOutput::set_blocking(bool blocking)
+{
+    this->blocking = blocking;
+}
+
+uint64_t RingOutput::get_dropped_frames()
+{
+    return this->dropped_frames;
+}
+
+void RingOutput::push_sample(float left, float right)
+{
+    audio_frame_t frame;
+    float out_left = left - this->capacitor_left;
+    float out_right = right - this->capacitor_right;
+    this->capacitor_left = left - (out_left * this->charge_factor);
+    this->capacitor_right = right - (out_right * this->charge_factor);
+    // Filter can overshoot on large steps
+    frame.left = (int16_t)std::max(-32768.0f, std::min(32767.0f, out_left));
+    frame.right = (int16_t)std::max(-32768.0f, std::min(32767.0f, out_right));
+
+    while (! this->ring->push(frame))
+    {
+        if (! this->blocking)
+        {
+            this->dropped_frames ++;
+            return;
+        }
+        std::this_thread::yield();
+    }
+}
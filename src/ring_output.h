@@ -0,0 +1,44 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+#pragma once
+
+#include <memory>
+
+#include "timing.h"
+#include "apu_output.h"
+#include "audio_ring.h"
+
+// APU output which pushes host-rate samples to the audio ring, passing
+// them through a high-pass filter (as the DMG's output capacitor does).
+class RingOutput : public ApuOutput {
+public:
+    RingOutput(AudioRing *ring, unsigned int sample_rate);
+
+    // Wait for space in the ring, rather than dropping samples,
+    // for consumers that are not real-time (e.g. writing to file)
+    void set_blocking(bool blocking);
+    uint64_t get_dropped_frames();
+
+    // Adjust ratio of emulated to host time for produced samples
+    // (e.g. 1.001 produces 0.1% fewer samples), so that the rate
+    // samples are produced can track the rate they are played
+    virtual void set_rate_adjustment(double adjustment) = 0;
+
+protected:
+    unsigned int sample_rate;
+
+    void push_sample(float left, float right);
+
+private:
+    AudioRing *ring;
+    bool blocking;
+    uint64_t dropped_frames;
+
+    // High-pass filter state and per-sample charge factor
+    float capacitor_left;
+    float capacitor_right;
+    float charge_factor;
+};
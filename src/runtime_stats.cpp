@@ -0,0 +1,164 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+#include "runtime_stats.h"
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <cmath>
+
+RuntimeStats::RuntimeStats() :
+    cycles(0),
+    instructions(0),
+    frames_rendered(0),
+    frames_skipped(0),
+    frames_presented(0),
+    cpu_ns(0),
+    ppu_ns(0),
+    present_ns(0),
+    frame_time_total(0),
+    frame_time_min(UINT64_MAX),
+    frame_time_max(0),
+    frame_time_sum_squares(0),
+    interval_frame_time_min(UINT64_MAX),
+    interval_frame_time_max(0)
+{
+    this->start_time = std::chrono::steady_clock::now();
+    for (unsigned int bucket = 0; bucket < FRAME_TIME_BUCKETS; bucket ++)
+        this->frame_time_buckets[bucket].store(0, std::memory_order_relaxed);
+}
+
+void RuntimeStats::add_frame_time(int64_t nanoseconds)
+{
+    uint64_t frame_time = nanoseconds > 0 ? (uint64_t)nanoseconds : 0;
+    uint64_t bucket = frame_time / FRAME_TIME_BUCKET_NS;
+    if (bucket >= FRAME_TIME_BUCKETS)
+        bucket = FRAME_TIME_BUCKETS - 1;
+    RuntimeStats::add(this->frame_time_buckets[bucket]);
+    RuntimeStats::add(this->frame_time_total, frame_time);
+
+    uint64_t microseconds = (frame_time + 500) / 1000;
+    RuntimeStats::add(this->frame_time_sum_squares, microseconds * microseconds);
+    RuntimeStats::set_min(this->frame_time_min, frame_time);
+    RuntimeStats::set_max(this->frame_time_max, frame_time);
+    RuntimeStats::set_min(this->interval_frame_time_min, frame_time);
+    RuntimeStats::set_max(this->interval_frame_time_max, frame_time);
+}
+
+void RuntimeStats::snapshot(runtime_stats_t &stats)
+{
+    stats.elapsed_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - this->start_time).count();
+    stats.cycles = this->cycles.load(std::memory_order_relaxed);
+    stats.instructions = this->instructions.load(std::memory_order_relaxed);
+    stats.frames_rendered = this->frames_rendered.load(std::memory_order_relaxed);
+    stats.frames_skipped = this->frames_skipped.load(std::memory_order_relaxed);
+    stats.frames_presented = this->frames_presented.load(std::memory_order_relaxed);
+    stats.cpu_ns = this->cpu_ns.load(std::memory_order_relaxed);
+    stats.ppu_ns = this->ppu_ns.load(std::memory_order_relaxed);
+    stats.present_ns = this->present_ns.load(std::memory_order_relaxed);
+    stats.frame_time_total = this->frame_time_total.load(std::memory_order_relaxed);
+    stats.frame_time_min = this->frame_time_min.load(std::memory_order_relaxed);
+    stats.frame_time_max = this->frame_time_max.load(std::memory_order_relaxed);
+    stats.frame_time_sum_squares = this->frame_time_sum_squares.load(std::memory_order_relaxed);
+    stats.frame_time_count = 0;
+    for (unsigned int bucket = 0; bucket < FRAME_TIME_BUCKETS; bucket ++)
+    {
+        stats.frame_time_buckets[bucket] = this->frame_time_buckets[bucket].load(std::memory_order_relaxed);
+        stats.frame_time_count += stats.frame_time_buckets[bucket];
+    }
+}
+
+void RuntimeStats::take_interval_frame_time_range(uint64_t &min, uint64_t &max)
+{
+    min = this->interval_frame_time_min.exchange(UINT64_MAX, std::memory_order_relaxed);
+    max = this->interval_frame_time_max.exchange(0, std::memory_order_relaxed);
+}
+
+double RuntimeStats::get_frame_time_percentile(const runtime_stats_t &stats, double percentile)
+{
+    // Upper edge of the bucket containing the percentile
+    uint64_t target = (uint64_t)(percentile * stats.frame_time_count);
+    uint64_t count = 0;
+    for (unsigned int bucket = 0; bucket < FRAME_TIME_BUCKETS; bucket ++)
+    {
+        count += stats.frame_time_buckets[bucket];
+        if (count > target || (count == stats.frame_time_count && count != 0))
+            return (double)(bucket + 1) * FRAME_TIME_BUCKET_NS;
+    }
+    return 0;
+}
+
+double RuntimeStats::get_frame_time_stddev(uint64_t count, uint64_t total, uint64_t sum_squares)
+{
+    if (count == 0)
+        return 0;
+    // Variance is the mean of squares less the square of the mean,
+    // which may be slightly negative after rounding
+    double mean = total / 1000.0 / count;
+    double variance = (double)sum_squares / count - mean * mean;
+    return variance > 0 ? sqrt(variance) * 1000.0 : 0;
+}
+
+void RuntimeStats::print()
+{
+    std::unique_ptr<runtime_stats_t> stats(new runtime_stats_t);
+    this->snapshot(*stats);
+
+    // Stream state is left untouched, as this may run on the
+    // reporter thread whilst emulation is also printing
+    std::ostringstream text;
+    text <<
+        "Cycles: " << stats->cycles << std::endl <<
+        "Instructions: " << stats->instructions << std::endl <<
+        "Frames rendered: " << stats->frames_rendered << std::endl <<
+        "Frames skipped: " << stats->frames_skipped << std::endl <<
+        "Frames presented: " << stats->frames_presented << std::endl;
+
+    text << std::fixed << std::setprecision(3) <<
+        "Host time (s): CPU " << (stats->cpu_ns / 1000000000.0) <<
+        ", PPU " << (stats->ppu_ns / 1000000000.0) <<
+        ", present " << (stats->present_ns / 1000000000.0) <<
+        ", elapsed " << stats->elapsed_seconds << std::endl;
+    if (stats->frame_time_count != 0)
+        text <<
+            "Frame time (ms): mean " << (stats->frame_time_total / 1000000.0 / stats->frame_time_count) <<
+            ", std-dev " << (get_frame_time_stddev(stats->frame_time_count, stats->frame_time_total, stats->frame_time_sum_squares) / 1000000.0) <<
+            ", min " << (stats->frame_time_min / 1000000.0) <<
+            ", p50 " << (get_frame_time_percentile(*stats, 0.5) / 1000000.0) <<
+            ", p90 " << (get_frame_time_percentile(*stats, 0.9) / 1000000.0) <<
+            ", p99 " << (get_frame_time_percentile(*stats, 0.99) / 1000000.0) <<
+            ", max " << (stats->frame_time_max / 1000000.0) << std::endl;
+    std::cout << text.str() << std::flush;
+}
+
+void RuntimeStats::write_json(std::ostream &output)
+{
+    std::unique_ptr<runtime_stats_t> stats(new runtime_stats_t);
+    this->snapshot(*stats);
+
+    double frame_count = stats->frame_time_count ? (double)stats->frame_time_count : 1;
+    uint64_t frame_time_min = stats->frame_time_count ? stats->frame_time_min : 0;
+    std::ostringstream json;
+    json << std::fixed << std::setprecision(3) << "{\n" <<
+        "  \"elapsed_seconds\": " << stats->elapsed_seconds << ",\n" <<
+        "  \"cycles\": " << stats->cycles << ",\n" <<
+        "  \"instructions\": " << stats->instructions << ",\n" <<
+        "  \"frames_rendered\": " << stats->frames_rendered << ",\n" <<
+        "  \"frames_skipped\": " << stats->frames_skipped << ",\n" <<
+        "  \"frames_presented\": " << stats->frames_presented << ",\n" <<
+        "  \"host_ns\": {\"cpu\": " << stats->cpu_ns << ", \"ppu\": " << stats->ppu_ns <<
+            ", \"present\": " << stats->present_ns << "},\n" <<
+        "  \"frame_time_ms\": {\"count\": " << stats->frame_time_count <<
+            ", \"mean\": " << (stats->frame_time_total / 1000000.0 / frame_count) <<
+            ", \"stddev\": " << (get_frame_time_stddev(stats->frame_time_count, stats->frame_time_total, stats->frame_time_sum_squares) / 1000000.0) <<
+            ", \"min\": " << (frame_time_min / 1000000.0) <<
+            ", \"p50\": " << (get_frame_time_percentile(*stats, 0.5) / 1000000.0) <<
+            ", \"p90\": " << (get_frame_time_percentile(*stats, 0.9) / 1000000.0) <<
+            ", \"p99\": " << (get_frame_time_percentile(*stats, 0.99) / 1000000.0) <<
+            ", \"max\": " << (stats->frame_time_max / 1000000.0) << "}\n" <<
+        "}\n";
+    output << json.str();
+}
@@ -0,0 +1,100 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+#pragma once
+
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <ostream>
+#include <cstdint>
+
+// Frame time histogram, in 0.1ms buckets up to ~100ms, with longer
+// frames counted in the last bucket. Min, max and standard deviation
+// are tracked exactly, so the longest stalls are not hidden.
+#define FRAME_TIME_BUCKETS 1024
+#define FRAME_TIME_BUCKET_NS 100000
+
+// Values of all counters at one time
+struct runtime_stats_t {
+    double elapsed_seconds;
+    uint64_t cycles;
+    uint64_t instructions;
+    uint64_t frames_rendered;
+    uint64_t frames_skipped;
+    uint64_t frames_presented;
+    uint64_t cpu_ns;
+    uint64_t ppu_ns;
+    uint64_t present_ns;
+    uint64_t frame_time_count;
+    uint64_t frame_time_total;
+    uint64_t frame_time_min;
+    uint64_t frame_time_max;
+    // Sum of squared frame times, in microseconds squared,
+    // which would overflow within minutes in nanoseconds
+    uint64_t frame_time_sum_squares;
+    uint64_t frame_time_buckets[FRAME_TIME_BUCKETS];
+};
+
+// Counters for the running emulator, shared between components.
+// Each is updated by one relaxed atomic add, by the thread producing
+// the event, so they can be read at any time from other threads
+// (e.g. to report periodically), without slowing emulation.
+class RuntimeStats {
+public:
+    RuntimeStats();
+
+    static void add(std::atomic<uint64_t> &counter, uint64_t amount = 1) {
+        counter.fetch_add(amount, std::memory_order_relaxed);
+    };
+    static void set_min(std::atomic<uint64_t> &counter, uint64_t value) {
+        uint64_t current = counter.load(std::memory_order_relaxed);
+        while (value < current && ! counter.compare_exchange_weak(current, value, std::memory_order_relaxed));
+    };
+    static void set_max(std::atomic<uint64_t> &counter, uint64_t value) {
+        uint64_t current = counter.load(std::memory_order_relaxed);
+        while (value > current && ! counter.compare_exchange_weak(current, value, std::memory_order_relaxed));
+    };
+    // Record host time between frames
+    void add_frame_time(int64_t nanoseconds);
+
+    void snapshot(runtime_stats_t &stats);
+    // Min and max frame time since the last call, which are then reset,
+    // so that each report covers only its own interval
+    void take_interval_frame_time_range(uint64_t &min, uint64_t &max);
+    void print();
+    void write_json(std::ostream &output);
+
+    // Emulated cycles and instructions executed
+    std::atomic<uint64_t> cycles;
+    std::atomic<uint64_t> instructions;
+    // Frames that were drawn, and those emulated without drawing
+    std::atomic<uint64_t> frames_rendered;
+    std::atomic<uint64_t> frames_skipped;
+    // Frames shown by the display
+    std::atomic<uint64_t> frames_presented;
+    // Host time executing instructions, processing PPU events and
+    // presenting frames. CPU and PPU time are estimated from a sample
+    // of events, as timing every event would cost more than most events.
+    std::atomic<uint64_t> cpu_ns;
+    std::atomic<uint64_t> ppu_ns;
+    std::atomic<uint64_t> present_ns;
+
+    // Percentile (0-1) of frame time in nanoseconds, from the histogram
+    static double get_frame_time_percentile(const runtime_stats_t &stats, double percentile);
+    // Standard deviation of frame time in nanoseconds, from the
+    // count, total and sum of squares of frame times
+    static double get_frame_time_stddev(uint64_t count, uint64_t total, uint64_t sum_squares);
+
+private:
+    std::chrono::steady_clock::time_point start_time;
+    std::atomic<uint64_t> frame_time_total;
+    std::atomic<uint64_t> frame_time_min;
+    std::atomic<uint64_t> frame_time_max;
+    std::atomic<uint64_t> frame_time_sum_squares;
+    std::atomic<uint64_t> interval_frame_time_min;
+    std::atomic<uint64_t> interval_frame_time_max;
+    std::atomic<uint64_t> frame_time_buckets[FRAME_TIME_BUCKETS];
+};
@@ -0,0 +1,156 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+#include "scheduler.h"
+
+Scheduler::Scheduler()
+{
+    this->current_cycle = 0;
+    this->next_event_cycle = UINT64_MAX;
+    this->heap_size = 0;
+    for (unsigned int event = 0; event < EVENT_COUNT; event ++)
+        this->heap_positions[event] = -1;
+}
+
+void Scheduler::schedule(SchedulerEvent event, uint64_t cycle)
+{
+    int position = this->heap_positions[event];
+    scheduled_event_t entry = {cycle, event};
+
+    if (position == -1)
+    {
+        // Add to end of heap
+        position = (int)this->heap_size;
+        this->heap_size ++;
+        this->set_heap_entry(position, entry);
+        this->sift_up(position);
+    }
+    else
+    {
+        // Move existing entry in whichever direction is required
+        bool earlier = cycle < this->heap[position].cycle;
+        this->set_heap_entry(position, entry);
+        if (earlier)
+            this->sift_up(position);
+        else
+            this->sift_down(position);
+    }
+
+    this->next_event_cycle = this->heap[0].cycle;
+}
+
+void Scheduler::cancel(SchedulerEvent event)
+{
+    if (this->heap_positions[event] != -1)
+        this->remove_at(this->heap_positions[event]);
+}
+
+bool Scheduler::is_scheduled(SchedulerEvent event)
+{
+    return this->heap_positions[event] != -1;
+}
+
+uint64_t Scheduler::get_event_cycle(SchedulerEvent event)
+{
+    if (this->heap_positions[event] == -1)
+        return UINT64_MAX;
+    return this->heap[this->heap_positions[event]].cycle;
+}
+
+bool Scheduler::pop_due_event(SchedulerEvent &event)
+{
+    if (this->heap_size == 0 || this->heap[0].cycle > this->current_cycle)
+        return false;
+
+    event = this->heap[0].event;
+    this->remove_at(0);
+    return true;
+}
+
+bool Scheduler::is_before(const scheduled_event_t &first, const scheduled_event_t &second)
+{
+    // Events on the same cycle are ordered by event type
+    if (first.cycle != second.cycle)
+        return first.cycle < second.cycle;
+    return first.event < second.event;
+}
+
+void Scheduler::set_heap_entry(unsigned int position, const scheduled_event_t &entry)
+{
+    this->heap[position] = entry;
+    this->heap_positions[entry.event] = (int)position;
+}
+
+void Scheduler::sift_up(unsigned int position)
+{
+    scheduled_event_t entry = this->heap[position];
+    while (position > 0)
+    {
+        unsigned int parent = (position - 1) / 2;
+        if (! this->is_before(entry, this->heap[parent]))
+            break;
+        this->set_heap_entry(position, this->heap[parent]);
+        position = parent;
+    }
+    this->set_heap_entry(position, entry);
+}
+
+void Scheduler::sift_down(unsigned int position)
+{
+    scheduled_event_t entry = this->heap[position];
+    while (true)
+    {
+        unsigned int child = (position * 2) + 1;
+        if (child >= this->heap_size)
+            break;
+        if ((child + 1) < this->heap_size && this->is_before(this->heap[child + 1], this->heap[child]))
+            child ++;
+        if (! this->is_before(this->heap[child], entry))
+            break;
+        this->set_heap_entry(position, this->heap[child]);
+        position = child;
+    }
+    this->set_heap_entry(position, entry);
+}
+
+void Scheduler::remove_at(unsigned int position)
+{
+    SchedulerEvent event = this->heap[position].event;
+    this->heap_size --;
+
+    // Replace with last entry and restore heap order
+    if (position != this->heap_size)
+    {
+        this->set_heap_entry(position, this->heap[this->heap_size]);
+        if (position > 0 && this->is_before(this->heap[position], this->heap[(position - 1) / 2]))
+            this->sift_up(position);
+        else
+            this->sift_down(position);
+    }
+    this->heap_positions[event] = -1;
+
+    this->next_event_cycle = this->heap_size ? this->heap[0].cycle : UINT64_MAX;
+}
+
+void Scheduler::save_state(scheduler_state_t &state)
+{
+    state.current_cycle = this->current_cycle;
+    for (unsigned int event = 0; event < EVENT_COUNT; event ++)
+        state.event_cycles[event] = this->get_event_cycle((SchedulerEvent)event);
+}
+
+void Scheduler::load_state(const scheduler_state_t &state)
+{
+    // Rebuild the heap, so that it does not depend on the order
+    // events were originally scheduled in
+    this->current_cycle = state.current_cycle;
+    for (unsigned int event = 0; event < EVENT_COUNT; event ++)
+    {
+        if (state.event_cycles[event] == UINT64_MAX)
+            this->cancel((SchedulerEvent)event);
+        else
+            this->schedule((SchedulerEvent)event, state.event_cycles[event]);
+    }
+}
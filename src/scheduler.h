@@ -0,0 +1,86 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+#pragma once
+
+#include <memory>
+#include <cstdint>
+
+// Scheduled events, each of which can be pending at most once.
+// Events due on the same cycle are processed in this order.
+enum SchedulerEvent {
+    // VPU mode transition
+    EVENT_VPU,
+    // Capture screenshot and stop
+    EVENT_SCREENSHOT,
+    // Timer counter overflow
+    EVENT_TIMER,
+    // Serial transfer complete
+    EVENT_SERIAL,
+    // APU frame sequencer step
+    EVENT_APU,
+    EVENT_COUNT
+};
+
+// Saved cycle counter and cycle of each event, UINT64_MAX if not scheduled
+struct scheduler_state_t {
+    uint64_t current_cycle;
+    uint64_t event_cycles[EVENT_COUNT];
+};
+
+// Global cycle counter and queue of upcoming events, ordered by
+// cycle in a min-heap. Components schedule their next deadline,
+// rather than being polled each cycle, and the CPU runs until
+// the earliest deadline.
+class Scheduler {
+public:
+    Scheduler();
+
+    // Cycles since start-up
+    uint64_t get_cycle() {
+        return this->current_cycle;
+    };
+    void advance(uint64_t cycles) {
+        this->current_cycle += cycles;
+    };
+    // Cycle of earliest pending event, UINT64_MAX if there are none
+    uint64_t get_next_event_cycle() {
+        return this->next_event_cycle;
+    };
+
+    // Schedule event for the given cycle, replacing any pending occurrence
+    void schedule(SchedulerEvent event, uint64_t cycle);
+    void cancel(SchedulerEvent event);
+    bool is_scheduled(SchedulerEvent event);
+    uint64_t get_event_cycle(SchedulerEvent event);
+
+    // Remove the earliest event that is due by the current cycle,
+    // returning false when none are due
+    bool pop_due_event(SchedulerEvent &event);
+
+    void save_state(scheduler_state_t &state);
+    void load_state(const scheduler_state_t &state);
+
+private:
+    struct scheduled_event_t {
+        uint64_t cycle;
+        SchedulerEvent event;
+    };
+
+    uint64_t current_cycle;
+    uint64_t next_event_cycle;
+
+    // Binary min-heap, with the position of each event in the heap,
+    // so that pending events can be rescheduled or cancelled
+    scheduled_event_t heap[EVENT_COUNT];
+    unsigned int heap_size;
+    int heap_positions[EVENT_COUNT];
+
+    bool is_before(const scheduled_event_t &first, const scheduled_event_t &second);
+    void set_heap_entry(unsigned int position, const scheduled_event_t &entry);
+    void sift_up(unsigned int position);
+    void sift_down(unsigned int position);
+    void remove_at(unsigned int position);
+};
@@ -0,0 +1,207 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+#include "screenshot_writer.h"
+
+#include <iostream>
+#include <stdio.h>
+#include <string.h>
+
+// Size of BMP file header and BITMAPINFOHEADER
+#define BMP_FILE_HEADER_SIZE 14
+#define BMP_INFO_HEADER_SIZE 40
+
+ScreenshotWriter::ScreenshotWriter()
+{
+    this->stopping = false;
+}
+
+ScreenshotWriter::~ScreenshotWriter()
+{
+    this->finish();
+}
+
+ScreenshotFormat ScreenshotWriter::get_format(const char *file_path)
+{
+    const char *extension = strrchr(file_path, '.');
+    if (extension != nullptr)
+    {
+        if (strcmp(extension, ".ppm") == 0)
+            return ScreenshotFormat::SCREENSHOT_PPM;
+        if (strcmp(extension, ".raw") == 0)
+            return ScreenshotFormat::SCREENSHOT_RAW_INDEX;
+    }
+    return ScreenshotFormat::SCREENSHOT_BMP;
+}
+
+void ScreenshotWriter::capture(const char *file_path, const frame_buffer_t *frame, const uint32_t color_scheme[4])
+{
+    screenshot_job_t *job = new screenshot_job_t;
+    job->file_path = file_path;
+    job->format = ScreenshotWriter::get_format(file_path);
+    memcpy(&job->frame, frame, sizeof(job->frame));
+    memcpy(job->color_scheme, color_scheme, sizeof(job->color_scheme));
+
+    std::lock_guard<std::mutex> lock(this->jobs_mutex);
+    this->jobs.push_back(job);
+    // Writer thread is only started once the first screenshot is taken
+    if (! this->writer_thread.joinable())
+    {
+        this->stopping = false;
+        this->writer_thread = std::thread(&ScreenshotWriter::run, this);
+    }
+    this->jobs_cv.notify_one();
+}
+
+void ScreenshotWriter::finish()
+{
+    {
+        std::lock_guard<std::mutex> lock(this->jobs_mutex);
+        if (! this->writer_thread.joinable())
+            return;
+        this->stopping = true;
+        this->jobs_cv.notify_one();
+    }
+    this->writer_thread.join();
+}
+
+void ScreenshotWriter::run()
+{
+    std::unique_lock<std::mutex> lock(this->jobs_mutex);
+    while (true)
+    {
+        this->jobs_cv.wait(lock, [this] { return this->stopping || ! this->jobs.empty(); });
+
+        // Write remaining screenshots before stopping
+        if (this->jobs.empty())
+            return;
+
+        screenshot_job_t *job = this->jobs.front();
+        this->jobs.pop_front();
+
+        lock.unlock();
+        this->write(job);
+        delete job;
+        lock.lock();
+    }
+}
+
+void ScreenshotWriter::write(screenshot_job_t *job)
+{
+    FILE *fh = fopen(job->file_path.c_str(), "wb");
+    if (fh == nullptr)
+    {
+        std::cout << "Unable to open screenshot file: " << job->file_path << std::endl;
+        return;
+    }
+
+    bool success = false;
+    switch (job->format)
+    {
+        case ScreenshotFormat::SCREENSHOT_BMP:
+            success = this->write_bmp(fh, &job->frame);
+            break;
+        case ScreenshotFormat::SCREENSHOT_PPM:
+            success = this->write_ppm(fh, &job->frame);
+            break;
+        case ScreenshotFormat::SCREENSHOT_RAW_INDEX:
+            success = this->write_raw_index(fh, &job->frame, job->color_scheme);
+            break;
+    }
+
+    if (fclose(fh) != 0 || ! success)
+        std::cout << "Failed to write screenshot: " << job->file_path << std::endl;
+}
+
+static void put_le16(uint8_t *data, uint16_t val)
+{
+    data[0] = (uint8_t)(val & 0xff);
+    data[1] = (uint8_t)(val >> 8);
+}
+
+static void put_le32(uint8_t *data, uint32_t val)
+{
+    for (unsigned int itx = 0; itx < 4; itx ++)
+        data[itx] = (uint8_t)((val >> (itx * 8)) & 0xff);
+}
+
+bool ScreenshotWriter::write_bmp(FILE *fh, const frame_buffer_t *frame)
+{
+    // 32-bit BGRA, with negative height, so that rows are stored top-down
+    // and the framebuffer can be written directly on little-endian hosts
+    const uint32_t data_size = SCREEN_PIXEL_WIDTH * SCREEN_PIXEL_HEIGHT * sizeof(uint32_t);
+    uint8_t header[BMP_FILE_HEADER_SIZE + BMP_INFO_HEADER_SIZE];
+    memset(header, 0, sizeof(header));
+
+    header[0] = 'B';
+    header[1] = 'M';
+    put_le32(&header[2], sizeof(header) + data_size);
+    put_le32(&header[10], sizeof(header));
+
+    uint8_t *info = &header[BMP_FILE_HEADER_SIZE];
+    put_le32(&info[0], BMP_INFO_HEADER_SIZE);
+    put_le32(&info[4], SCREEN_PIXEL_WIDTH);
+    put_le32(&info[8], (uint32_t)(-SCREEN_PIXEL_HEIGHT));
+    put_le16(&info[12], 1);
+    put_le16(&info[14], 32);
+    put_le32(&info[20], data_size);
+
+    if (fwrite(header, sizeof(header), 1, fh) != 1)
+        return false;
+
+    uint8_t row[SCREEN_PIXEL_WIDTH * 4];
+    for (unsigned int y = 0; y < SCREEN_PIXEL_HEIGHT; y ++)
+    {
+        for (unsigned int x = 0; x < SCREEN_PIXEL_WIDTH; x ++)
+            put_le32(&row[x * 4], frame->pixels[(y * SCREEN_PIXEL_WIDTH) + x]);
+        if (fwrite(row, sizeof(row), 1, fh) != 1)
+            return false;
+    }
+    return true;
+}
+
+bool ScreenshotWriter::write_ppm(FILE *fh, const frame_buffer_t *frame)
+{
+    if (fprintf(fh, "P6\n%d %d\n255\n", SCREEN_PIXEL_WIDTH, SCREEN_PIXEL_HEIGHT) < 0)
+        return false;
+
+    uint8_t row[SCREEN_PIXEL_WIDTH * 3];
+    for (unsigned int y = 0; y < SCREEN_PIXEL_HEIGHT; y ++)
+    {
+        for (unsigned int x = 0; x < SCREEN_PIXEL_WIDTH; x ++)
+        {
+            uint32_t pixel = frame->pixels[(y * SCREEN_PIXEL_WIDTH) + x];
+            row[(x * 3)] = (uint8_t)(pixel >> 16);
+            row[(x * 3) + 1] = (uint8_t)(pixel >> 8);
+            row[(x * 3) + 2] = (uint8_t)pixel;
+        }
+        if (fwrite(row, sizeof(row), 1, fh) != 1)
+            return false;
+    }
+    return true;
+}
+
+bool ScreenshotWriter::write_raw_index(FILE *fh, const frame_buffer_t *frame, const uint32_t color_scheme[4])
+{
+    // Convert host colours back to shades
+    uint8_t row[SCREEN_PIXEL_WIDTH];
+    for (unsigned int y = 0; y < SCREEN_PIXEL_HEIGHT; y ++)
+    {
+        for (unsigned int x = 0; x < SCREEN_PIXEL_WIDTH; x ++)
+        {
+            uint32_t pixel = frame->pixels[(y * SCREEN_PIXEL_WIDTH) + x];
+            row[x] = 0;
+            for (uint8_t shade = 0; shade < 4; shade ++)
+                if (color_scheme[shade] == pixel)
+                {
+                    row[x] = shade;
+                    break;
+                }
+        }
+        if (fwrite(row, sizeof(row), 1, fh) != 1)
+            return false;
+    }
+    return true;
+}
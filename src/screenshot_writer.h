@@ -0,0 +1,59 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "frame_buffer.h"
+
+enum ScreenshotFormat {
+    SCREENSHOT_BMP,
+    SCREENSHOT_PPM,
+    // One byte per pixel, containing the shade (0-3), without header
+    SCREENSHOT_RAW_INDEX
+};
+
+// Copy of a completed frame, waiting to be written
+struct screenshot_job_t {
+    std::string file_path;
+    ScreenshotFormat format;
+    frame_buffer_t frame;
+    // Host colour of each shade, for converting back to shades
+    uint32_t color_scheme[4];
+};
+
+// Encodes and writes screenshots on its own thread, so that the
+// emulation thread only copies the frame
+class ScreenshotWriter {
+public:
+    ScreenshotWriter();
+    ~ScreenshotWriter();
+
+    // Queue frame to be written, selecting the format from the file extension
+    void capture(const char *file_path, const frame_buffer_t *frame, const uint32_t color_scheme[4]);
+    // Wait for all queued screenshots to be written
+    void finish();
+
+    static ScreenshotFormat get_format(const char *file_path);
+
+private:
+    std::thread writer_thread;
+    std::mutex jobs_mutex;
+    std::condition_variable jobs_cv;
+    std::deque<screenshot_job_t*> jobs;
+    bool stopping;
+
+    void run();
+    void write(screenshot_job_t *job);
+    bool write_bmp(FILE *fh, const frame_buffer_t *frame);
+    bool write_ppm(FILE *fh, const frame_buffer_t *frame);
+    bool write_raw_index(FILE *fh, const frame_buffer_t *frame, const uint32_t color_scheme[4]);
+};
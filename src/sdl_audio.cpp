@@ -0,0 +1,80 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+#include "sdl_audio.h"
+
+#include <iostream>
+#include <string.h>
+
+SdlAudio::SdlAudio(AudioRing *ring)
+{
+    this->ring = ring;
+    this->device = 0;
+    this->last_frame.left = 0;
+    this->last_frame.right = 0;
+    this->underrun_frames = 0;
+}
+
+SdlAudio::~SdlAudio()
+{
+    this->stop();
+}
+
+bool SdlAudio::start(unsigned int sample_rate)
+{
+    if (SDL_InitSubSystem(SDL_INIT_AUDIO) != 0)
+    {
+        std::cout << "Unable to initialise audio: " << SDL_GetError() << std::endl;
+        return false;
+    }
+
+    SDL_AudioSpec desired;
+    SDL_AudioSpec obtained;
+    memset(&desired, 0, sizeof(desired));
+    desired.freq = sample_rate;
+    desired.format = AUDIO_S16SYS;
+    desired.channels = 2;
+    desired.samples = this->DEVICE_BUFFER_FRAMES;
+    desired.callback = &SdlAudio::audio_callback;
+    desired.userdata = this;
+
+    // SDL converts, if the device does not support the format
+    this->device = SDL_OpenAudioDevice(NULL, 0, &desired, &obtained, 0);
+    if (this->device == 0)
+    {
+        std::cout << "Unable to open audio device: " << SDL_GetError() << std::endl;
+        SDL_QuitSubSystem(SDL_INIT_AUDIO);
+        return false;
+    }
+    SDL_PauseAudioDevice(this->device, 0);
+    return true;
+}
+
+void SdlAudio::stop()
+{
+    if (this->device == 0)
+        return;
+    SDL_CloseAudioDevice(this->device);
+    SDL_QuitSubSystem(SDL_INIT_AUDIO);
+    this->device = 0;
+
+    std::cout << "Audio device: " << std::dec << this->underrun_frames << " samples underrun" << std::endl;
+}
+
+void SdlAudio::audio_callback(void *userdata, Uint8 *stream, int length)
+{
+    ((SdlAudio*)userdata)->fill((audio_frame_t*)stream, length / sizeof(audio_frame_t));
+}
+
+void SdlAudio::fill(audio_frame_t *frames, unsigned int frame_count)
+{
+    for (unsigned int itx = 0; itx < frame_count; itx ++)
+    {
+        // On underrun, hold the last sample rather than clicking to silence
+        if (! this->ring->pop(this->last_frame))
+            this->underrun_frames ++;
+        frames[itx] = this->last_frame;
+    }
+}
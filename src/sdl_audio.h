@@ -0,0 +1,36 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+#pragma once
+
+#include <memory>
+#include <SDL.h>
+
+#include "audio_ring.h"
+
+// Plays samples from the audio ring through an SDL audio device.
+// The device callback runs on SDL's audio thread and only pops
+// from the ring, so it never waits on emulation.
+class SdlAudio {
+public:
+    SdlAudio(AudioRing *ring);
+    ~SdlAudio();
+
+    bool start(unsigned int sample_rate);
+    void stop();
+
+private:
+    // Frames requested per callback (~23ms at 44.1kHz)
+    const uint16_t DEVICE_BUFFER_FRAMES = 1024;
+
+    AudioRing *ring;
+    SDL_AudioDeviceID device;
+    // Audio thread only, until stopped
+    audio_frame_t last_frame;
+    uint64_t underrun_frames;
+
+    static void audio_callback(void *userdata, Uint8 *stream, int length);
+    void fill(audio_frame_t *frames, unsigned int frame_count);
+};
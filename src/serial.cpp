@@ -0,0 +1,71 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+#include "serial.h"
+
+Serial::Serial(RAM *ram, Scheduler *scheduler, InterruptController *interrupts)
+{
+    this->scheduler = scheduler;
+    this->interrupts = interrupts;
+    this->sb = 0;
+    this->sc = 0;
+
+    ram->register_io_handler(this->SB_ADDR, this);
+    ram->register_io_handler(this->SC_ADDR, this);
+}
+
+void Serial::add_sink(SerialSink *sink)
+{
+    this->sinks.push_back(sink);
+}
+
+uint8_t Serial::io_read(uint16_t address, uint8_t stored_val)
+{
+    if (address == this->SB_ADDR)
+        return this->sb;
+    return this->SC_UNUSED_BITS | this->sc;
+}
+
+void Serial::io_write(uint16_t address, uint8_t val)
+{
+    if (address == this->SB_ADDR)
+    {
+        this->sb = val;
+        return;
+    }
+
+    this->sc = val & (this->SC_TRANSFER_START | this->SC_INTERNAL_CLOCK);
+
+    // With an external clock, and nothing connected, the
+    // transfer waits indefinitely
+    if ((this->sc & this->SC_TRANSFER_START) && (this->sc & this->SC_INTERNAL_CLOCK))
+        this->scheduler->schedule(SchedulerEvent::EVENT_SERIAL,
+                                  this->scheduler->get_cycle() + this->TRANSFER_CYCLES);
+    else
+        this->scheduler->cancel(SchedulerEvent::EVENT_SERIAL);
+}
+
+void Serial::transfer_event()
+{
+    for (auto sink : this->sinks)
+        sink->serial_byte(this->sb);
+
+    // Bits shifted in from the disconnected line are all high
+    this->sb = 0xff;
+    this->sc &= (uint8_t)~this->SC_TRANSFER_START;
+    this->interrupts->raise(InterruptType::INTERRUPT_SERIAL);
+}
+
+void Serial::save_state(serial_state_t &state)
+{
+    state.sb = this->sb;
+    state.sc = this->sc;
+}
+
+void Serial::load_state(const serial_state_t &state)
+{
+    this->sb = state.sb;
+    this->sc = state.sc;
+}
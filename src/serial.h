@@ -0,0 +1,58 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+#pragma once
+
+#include <memory>
+#include <vector>
+#include "ram.h"
+#include "io_handler.h"
+#include "scheduler.h"
+#include "interrupt_controller.h"
+#include "serial_sink.h"
+
+// Saved state of serial registers. Transfers in progress
+// are restored with the scheduler.
+struct serial_state_t {
+    uint8_t sb;
+    uint8_t sc;
+};
+
+// Serial transfer data (SB) and control (SC) registers.
+// No device is connected, so transfers only complete when using the
+// internal clock, after which the sent byte is passed to each sink,
+// 0xff is received and the serial interrupt is raised.
+class Serial : public IoHandler {
+public:
+    Serial(RAM *ram, Scheduler *scheduler, InterruptController *interrupts);
+
+    void add_sink(SerialSink *sink);
+
+    uint8_t io_read(uint16_t address, uint8_t stored_val);
+    void io_write(uint16_t address, uint8_t val);
+
+    // Scheduled transfer has completed
+    void transfer_event();
+
+    void save_state(serial_state_t &state);
+    void load_state(const serial_state_t &state);
+
+private:
+    const uint16_t SB_ADDR = 0xff01;
+    const uint16_t SC_ADDR = 0xff02;
+    const uint8_t SC_TRANSFER_START = 0x80;
+    const uint8_t SC_INTERNAL_CLOCK = 0x01;
+    // Bits 1-6 are unused and always read as 1
+    const uint8_t SC_UNUSED_BITS = 0x7e;
+    // Internal clock runs at 8192Hz, shifting one bit per clock
+    const uint64_t TRANSFER_CYCLES = 8 * 512;
+
+    Scheduler *scheduler;
+    InterruptController *interrupts;
+    std::vector<SerialSink*> sinks;
+
+    uint8_t sb;
+    uint8_t sc;
+};
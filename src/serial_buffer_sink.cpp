@@ -0,0 +1,48 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+#include "serial_buffer_sink.h"
+
+SerialBufferSink::SerialBufferSink()
+{
+    this->result = SerialResult::SERIAL_PENDING;
+}
+
+void SerialBufferSink::add_pattern(const char *pattern, SerialResult result)
+{
+    serial_pattern_t serial_pattern;
+    serial_pattern.text = pattern;
+    serial_pattern.result = result;
+    this->patterns.push_back(serial_pattern);
+}
+
+void SerialBufferSink::serial_byte(uint8_t val)
+{
+    this->output.push_back((char)val);
+    if (this->result != SerialResult::SERIAL_PENDING)
+        return;
+
+    // Only a match ending with the new byte can be new
+    for (auto &pattern : this->patterns)
+    {
+        if (pattern.text.size() <= this->output.size() &&
+            this->output.compare(this->output.size() - pattern.text.size(),
+                                 pattern.text.size(), pattern.text) == 0)
+        {
+            this->result = pattern.result;
+            return;
+        }
+    }
+}
+
+SerialResult SerialBufferSink::get_result()
+{
+    return this->result;
+}
+
+const std::string &SerialBufferSink::get_output()
+{
+    return this->output;
+}
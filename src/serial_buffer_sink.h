@@ -0,0 +1,48 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "serial_sink.h"
+
+enum SerialResult {
+    // No patterns, or none matched yet
+    SERIAL_PENDING,
+    SERIAL_PASSED,
+    SERIAL_FAILED
+};
+
+// Collects serial output in memory, matching it against pass and
+// fail patterns, so that test ROMs which report results over the
+// serial port (e.g. "Passed"/"Failed") can stop as soon as they
+// have a result.
+class SerialBufferSink : public SerialSink {
+public:
+    SerialBufferSink();
+
+    // Add text which, once sent, passes or fails the run
+    void add_pattern(const char *pattern, SerialResult result);
+
+    void serial_byte(uint8_t val);
+
+    // Result of first pattern to match, which is then final
+    SerialResult get_result();
+    // All output received
+    const std::string &get_output();
+
+private:
+    struct serial_pattern_t {
+        std::string text;
+        SerialResult result;
+    };
+
+    std::string output;
+    std::vector<serial_pattern_t> patterns;
+    SerialResult result;
+};
@@ -0,0 +1,43 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+#include "serial_file_sink.h"
+
+#include <iostream>
+#include <string.h>
+
+SerialFileSink::SerialFileSink()
+{
+    this->output = nullptr;
+}
+
+SerialFileSink::~SerialFileSink()
+{
+    if (this->output != nullptr && this->output != stdout)
+        fclose(this->output);
+}
+
+bool SerialFileSink::open(const char *path)
+{
+    if (strcmp(path, "-") == 0)
+        this->output = stdout;
+    else
+        this->output = fopen(path, "wb");
+
+    if (this->output == nullptr)
+    {
+        std::cout << "Unable to open serial output: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void SerialFileSink::serial_byte(uint8_t val)
+{
+    fputc(val, this->output);
+    // Output is line based, so show each line as it completes
+    if (val == '\n')
+        fflush(this->output);
+}
@@ -0,0 +1,26 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+#pragma once
+
+#include <memory>
+#include <stdio.h>
+
+#include "serial_sink.h"
+
+// Writes serial output to a file or stdout, as it is sent
+class SerialFileSink : public SerialSink {
+public:
+    SerialFileSink();
+    ~SerialFileSink();
+
+    // Open output file ('-' for stdout)
+    bool open(const char *path);
+
+    void serial_byte(uint8_t val);
+
+private:
+    FILE *output;
+};
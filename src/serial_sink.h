@@ -0,0 +1,19 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+#pragma once
+
+#include <memory>
+#include <cstdint>
+
+// Receives bytes sent over the serial port, in place of
+// a connected device.
+class SerialSink {
+public:
+    virtual ~SerialSink() {};
+
+    // Called as each transfer completes, with the byte sent
+    virtual void serial_byte(uint8_t val) = 0;
+};
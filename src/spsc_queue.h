@@ -0,0 +1,52 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+#pragma once
+
+#include <memory>
+#include <atomic>
+
+// Lock-free bounded queue, for a single producer thread and a
+// single consumer thread. SIZE must be a power of 2.
+template <typename T, unsigned int SIZE>
+class SpscQueue {
+public:
+    SpscQueue() : head(0), tail(0) {};
+
+    // Producer - returns false if queue is full
+    bool push(const T &item) {
+        unsigned long head_val = this->head.load(std::memory_order_relaxed);
+        if ((head_val - this->tail.load(std::memory_order_acquire)) == SIZE)
+            return false;
+        this->items[head_val & (SIZE - 1)] = item;
+        this->head.store(head_val + 1, std::memory_order_release);
+        return true;
+    };
+
+    // Consumer - returns false if queue is empty
+    bool pop(T &item) {
+        unsigned long tail_val = this->tail.load(std::memory_order_relaxed);
+        if (tail_val == this->head.load(std::memory_order_acquire))
+            return false;
+        item = this->items[tail_val & (SIZE - 1)];
+        this->tail.store(tail_val + 1, std::memory_order_release);
+        return true;
+    };
+
+    // Number of queued items (approximate whilst other thread is active)
+    unsigned long size() {
+        return this->head.load(std::memory_order_acquire) - this->tail.load(std::memory_order_acquire);
+    };
+
+private:
+    static_assert((SIZE & (SIZE - 1)) == 0, "SpscQueue size must be a power of 2");
+
+    T items[SIZE];
+    // Pad between indexes, so producer and consumer do not
+    // contend on the same cache line
+    std::atomic<unsigned long> head;
+    char padding[64];
+    std::atomic<unsigned long> tail;
+};
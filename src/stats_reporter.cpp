@@ -0,0 +1,118 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+#include "stats_reporter.h"
+#include "timing.h"
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <chrono>
+#include <signal.h>
+
+std::atomic<bool> StatsReporter::dump_requested(false);
+
+StatsReporter::StatsReporter(RuntimeStats *stats) :
+    previous(new runtime_stats_t)
+{
+    this->stats = stats;
+    this->interval = 0;
+    this->stop_requested = false;
+}
+
+StatsReporter::~StatsReporter()
+{
+    this->stop();
+}
+
+void StatsReporter::handle_signal(int signal)
+{
+    (void)signal;
+    StatsReporter::dump_requested.store(true, std::memory_order_relaxed);
+}
+
+void StatsReporter::start(double interval)
+{
+    this->interval = interval;
+    this->stats->snapshot(*this->previous);
+    signal(SIGUSR1, StatsReporter::handle_signal);
+    this->reporter_thread = std::thread(&StatsReporter::run, this);
+}
+
+void StatsReporter::stop()
+{
+    if (! this->reporter_thread.joinable())
+        return;
+    this->stop_requested.store(true, std::memory_order_relaxed);
+    this->reporter_thread.join();
+    signal(SIGUSR1, SIG_DFL);
+}
+
+void StatsReporter::run()
+{
+    std::chrono::steady_clock::time_point next_report = std::chrono::steady_clock::now() +
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(this->interval));
+    std::unique_ptr<runtime_stats_t> current(new runtime_stats_t);
+
+    while (! this->stop_requested.load(std::memory_order_relaxed))
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(STATS_REPORTER_POLL_MS));
+
+        if (StatsReporter::dump_requested.exchange(false, std::memory_order_relaxed))
+            this->stats->print();
+
+        if (this->interval > 0 && std::chrono::steady_clock::now() >= next_report)
+        {
+            this->stats->snapshot(*current);
+            this->print_rates(*current);
+            this->previous.swap(current);
+            next_report += std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::duration<double>(this->interval));
+        }
+    }
+}
+
+void StatsReporter::print_rates(const runtime_stats_t &current)
+{
+    const runtime_stats_t &previous = *this->previous;
+    double seconds = current.elapsed_seconds - previous.elapsed_seconds;
+    if (seconds <= 0)
+        return;
+    uint64_t frames = current.frames_rendered + current.frames_skipped -
+        previous.frames_rendered - previous.frames_skipped;
+    double per_frame = frames ? 1000000.0 * frames : 1;
+
+    // Frame time distribution over this interval only
+    std::unique_ptr<runtime_stats_t> interval_stats(new runtime_stats_t);
+    interval_stats->frame_time_count = current.frame_time_count - previous.frame_time_count;
+    for (unsigned int bucket = 0; bucket < FRAME_TIME_BUCKETS; bucket ++)
+        interval_stats->frame_time_buckets[bucket] = current.frame_time_buckets[bucket] - previous.frame_time_buckets[bucket];
+    uint64_t frame_time_min, frame_time_max;
+    this->stats->take_interval_frame_time_range(frame_time_min, frame_time_max);
+    double frame_time_stddev = RuntimeStats::get_frame_time_stddev(interval_stats->frame_time_count,
+        current.frame_time_total - previous.frame_time_total,
+        current.frame_time_sum_squares - previous.frame_time_sum_squares);
+
+    // Formatted separately, then written at once, as the emulation
+    // thread may be writing to the shared stream
+    std::ostringstream line;
+    line << std::fixed << std::setprecision(2) <<
+        "Stats: " << ((current.cycles - previous.cycles) / seconds / 1000000.0) << " MHz (" <<
+        std::setprecision(0) << ((current.cycles - previous.cycles) / seconds / CPU_CLOCK_HZ * 100.0) << "%), " <<
+        std::setprecision(2) << ((current.instructions - previous.instructions) / seconds / 1000000.0) << " MIPS, " <<
+        std::setprecision(1) << (frames / seconds) << " fps (" <<
+        (current.frames_skipped - previous.frames_skipped) << " skipped), " <<
+        std::setprecision(3) << "ms/frame: CPU " << ((current.cpu_ns - previous.cpu_ns) / per_frame) <<
+        ", PPU " << ((current.ppu_ns - previous.ppu_ns) / per_frame) <<
+        ", present " << ((current.present_ns - previous.present_ns) / per_frame);
+    if (interval_stats->frame_time_count != 0)
+        line << ", frame time min " << (frame_time_min / 1000000.0) <<
+            " p50 " << (RuntimeStats::get_frame_time_percentile(*interval_stats, 0.5) / 1000000.0) <<
+            " p99 " << (RuntimeStats::get_frame_time_percentile(*interval_stats, 0.99) / 1000000.0) <<
+            " max " << (frame_time_max / 1000000.0) <<
+            " std-dev " << (frame_time_stddev / 1000000.0);
+    line << std::endl;
+    std::cout << line.str() << std::flush;
+}
@@ -0,0 +1,45 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+#pragma once
+
+#include <memory>
+#include <atomic>
+#include <thread>
+
+#include "runtime_stats.h"
+
+// Time reporter thread waits between checks for a stop request or signal
+#define STATS_REPORTER_POLL_MS 100
+
+// Reports runtime stats from a separate thread, so that emulation
+// is not interrupted. Prints a line of rates every interval, when
+// enabled, and dumps all stats whenever SIGUSR1 is received.
+class StatsReporter {
+public:
+    StatsReporter(RuntimeStats *stats);
+    ~StatsReporter();
+
+    // Start reporting, printing rates every interval seconds, or only
+    // on SIGUSR1 for an interval of 0
+    void start(double interval);
+    void stop();
+
+private:
+    RuntimeStats *stats;
+    double interval;
+
+    std::thread reporter_thread;
+    std::atomic<bool> stop_requested;
+    // Stats at last periodic report
+    std::unique_ptr<runtime_stats_t> previous;
+
+    // Set by signal handler, as stats cannot be printed within it
+    static std::atomic<bool> dump_requested;
+    static void handle_signal(int signal);
+
+    void run();
+    void print_rates(const runtime_stats_t &current);
+};
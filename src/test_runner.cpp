@@ -5,6 +5,10 @@
 
 #include "./test_runner.h"
 #include <iostream>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
 
 TestRunner::TestRunner(VPU *vpu_inst, CPU *cpu_inst, RAM *ram_inst)
 {
@@ -87,6 +91,12 @@ void TestRunner::run_tests()
     this->test_cb_34();
     this->test_cb_35();
 
+    this->test_frame_hash();
+    this->test_joypad();
+    this->test_apu();
+    this->test_rewind();
+    this->test_movie();
+
     std::cout << std::endl << "Completed tests" << std::endl;
 
 }
@@ -1568,3 +1578,285 @@ void TestRunner::test_SWAP(reg8 *reg, uint8_t op_code)
     // Ensure that SP has moved on
     this->assert_equal(this->cpu_inst->r_pc.get_value(), 0x0006);
 }
+
+void TestRunner::test_frame_hash()
+{
+    std::cout << "frame hash";
+
+    // xxHash64 reference values, with seed 0
+    const char *long_input = "Nobody inspects the spammish repetition";
+    this->assert(FrameHasher::xxhash64("", 0, 0) == 0xef46db3751d8e999ULL);
+    this->assert(FrameHasher::xxhash64("abc", 3, 0) == 0x44bc2cf5ad770999ULL);
+    this->assert(FrameHasher::xxhash64(long_input, strlen(long_input), 0) == 0xfbcea83c8a378bf1ULL);
+
+    frame_buffer_t *frame = new frame_buffer_t;
+    memset(frame, 0, sizeof(frame_buffer_t));
+    uint64_t blank_hash = FrameHasher::xxhash64(frame->pixels, sizeof(frame->pixels), 0);
+    char spec[64];
+
+    // Expected hash passes as soon as it is seen
+    FrameHasher expect_hasher;
+    snprintf(spec, sizeof(spec), "10:%llx", (unsigned long long)blank_hash);
+    this->assert(expect_hasher.add_expected(spec));
+    frame->pixels[0] = 0xffffffff;
+    expect_hasher.add_frame(0, frame);
+    this->assert(expect_hasher.get_result() == FrameHashResult::HASH_PENDING);
+    frame->pixels[0] = 0;
+    expect_hasher.add_frame(1, frame);
+    this->assert(expect_hasher.get_result() == FrameHashResult::HASH_PASSED);
+
+    // Expected hash fails once the frame limit is reached
+    FrameHasher late_hasher;
+    snprintf(spec, sizeof(spec), "1:%llx", (unsigned long long)blank_hash);
+    this->assert(late_hasher.add_expected(spec));
+    frame->pixels[0] = 0xffffffff;
+    late_hasher.add_frame(0, frame);
+    this->assert(late_hasher.get_result() == FrameHashResult::HASH_PENDING);
+    late_hasher.add_frame(1, frame);
+    this->assert(late_hasher.get_result() == FrameHashResult::HASH_FAILED);
+
+    // Forbidden hash fails immediately
+    FrameHasher forbid_hasher;
+    snprintf(spec, sizeof(spec), "!%llx", (unsigned long long)blank_hash);
+    this->assert(forbid_hasher.add_expected(spec));
+    frame->pixels[0] = 0;
+    forbid_hasher.add_frame(0, frame);
+    this->assert(forbid_hasher.get_result() == FrameHashResult::HASH_FAILED);
+
+    delete frame;
+}
+
+void TestRunner::test_joypad()
+{
+    std::cout << "joypad";
+
+    RAM ram;
+    InterruptController interrupts(&ram);
+    Joypad joypad(&ram, &interrupts);
+    ram.set(0xffff, 0x10);
+
+    // Nothing pressed or selected
+    this->assert_equal(ram.get_val(0xff00), 0xff);
+
+    // Pressing an unselected button does not raise interrupt
+    joypad.set_button(JoypadButton::JOYPAD_START, true);
+    this->assert_equal(ram.get_val(0xff00), 0xff);
+    this->assert(! interrupts.has_pending());
+
+    // Selecting directions does not show action buttons
+    ram.set(0xff00, 0x20);
+    this->assert_equal(ram.get_val(0xff00), 0xef);
+    joypad.set_button(JoypadButton::JOYPAD_DOWN, true);
+    this->assert_equal(ram.get_val(0xff00), 0xe7);
+    this->assert(interrupts.has_pending());
+    this->assert_equal(interrupts.acknowledge(), 0x60);
+
+    // Selecting actions, with start already held, pulls a line low
+    joypad.set_button(JoypadButton::JOYPAD_DOWN, false);
+    this->assert(! interrupts.has_pending());
+    ram.set(0xff00, 0x10);
+    this->assert_equal(ram.get_val(0xff00), 0xd7);
+    this->assert(interrupts.has_pending());
+    interrupts.acknowledge();
+
+    // Releasing does not raise interrupt
+    joypad.set_button(JoypadButton::JOYPAD_START, false);
+    this->assert_equal(ram.get_val(0xff00), 0xdf);
+    this->assert(! interrupts.has_pending());
+}
+
+void TestRunner::test_apu()
+{
+    std::cout << "apu";
+
+    RAM ram;
+    Scheduler scheduler;
+    Apu apu(&ram, &scheduler);
+
+    // Registers cannot be written whilst powered off
+    ram.set(0xff24, 0x77);
+    this->assert_equal(ram.get_val(0xff24), 0x00);
+    this->assert_equal(ram.get_val(0xff26), 0x70);
+    ram.set(0xff26, 0x80);
+    this->assert_equal(ram.get_val(0xff26), 0xf0);
+
+    // Unused and write-only bits read as 1
+    ram.set(0xff10, 0x00);
+    this->assert_equal(ram.get_val(0xff10), 0x80);
+    ram.set(0xff11, 0x40);
+    this->assert_equal(ram.get_val(0xff11), 0x7f);
+    ram.set(0xff13, 0x12);
+    this->assert_equal(ram.get_val(0xff13), 0xff);
+    ram.set(0xff14, 0x00);
+    this->assert_equal(ram.get_val(0xff14), 0xbf);
+    ram.set(0xff1c, 0x20);
+    this->assert_equal(ram.get_val(0xff1c), 0xbf);
+    ram.set(0xff24, 0x77);
+    this->assert_equal(ram.get_val(0xff24), 0x77);
+    this->assert_equal(ram.get_val(0xff27), 0xff);
+
+    // Trigger sets channel status, until the length counter expires
+    // on the second length clock (frame sequencer steps 0 and 2)
+    ram.set(0xff17, 0xf0);
+    ram.set(0xff16, 0x3e);
+    ram.set(0xff19, 0xc0);
+    this->assert_equal(ram.get_val(0xff26), 0xf2);
+    apu.frame_sequencer_event();
+    apu.frame_sequencer_event();
+    this->assert_equal(ram.get_val(0xff26), 0xf2);
+    apu.frame_sequencer_event();
+    this->assert_equal(ram.get_val(0xff26), 0xf0);
+
+    // Turning the DAC off disables the channel, which cannot
+    // then be triggered
+    ram.set(0xff12, 0xf0);
+    ram.set(0xff14, 0x80);
+    this->assert_equal(ram.get_val(0xff26), 0xf1);
+    ram.set(0xff12, 0x00);
+    this->assert_equal(ram.get_val(0xff26), 0xf0);
+    ram.set(0xff14, 0x80);
+    this->assert_equal(ram.get_val(0xff26), 0xf0);
+
+    // Sweep overflow on trigger disables channel 1 immediately
+    ram.set(0xff12, 0xf0);
+    ram.set(0xff10, 0x11);
+    ram.set(0xff13, 0xff);
+    ram.set(0xff14, 0x87);
+    this->assert_equal(ram.get_val(0xff26), 0xf0);
+
+    // Power cycle, so the frame sequencer restarts from step 0,
+    // clearing all registers
+    ram.set(0xff26, 0x00);
+    this->assert_equal(ram.get_val(0xff24), 0x00);
+    this->assert_equal(ram.get_val(0xff10), 0x80);
+    ram.set(0xff26, 0x80);
+
+    // Sweep from 0x500 to 0x780 on step 2, which then overflows
+    // on the following check
+    ram.set(0xff12, 0xf0);
+    ram.set(0xff10, 0x11);
+    ram.set(0xff13, 0x00);
+    ram.set(0xff14, 0x85);
+    this->assert_equal(ram.get_val(0xff26), 0xf1);
+    apu.frame_sequencer_event();
+    apu.frame_sequencer_event();
+    this->assert_equal(ram.get_val(0xff26), 0xf1);
+    apu.frame_sequencer_event();
+    this->assert_equal(ram.get_val(0xff26), 0xf0);
+}
+
+void TestRunner::test_rewind()
+{
+    std::cout << "rewind";
+
+    // Identical buffers encode as one unchanged run, with a
+    // 2 byte length (300), and an empty changed run
+    uint8_t previous[300];
+    uint8_t next[300];
+    for (unsigned int itx = 0; itx < sizeof(previous); itx ++)
+        previous[itx] = (uint8_t)(itx * 7);
+    memcpy(next, previous, sizeof(next));
+    std::vector<uint8_t> delta;
+    RewindBuffer::encode_delta(previous, next, sizeof(previous), delta);
+    this->assert_equal((unsigned int)delta.size(), 3);
+    this->assert_equal(delta[0], 0xac);
+    this->assert_equal(delta[1], 0x02);
+    this->assert_equal(delta[2], 0x00);
+
+    // Changes separated by short unchanged runs are joined, and
+    // changes at either end are kept
+    next[0] ^= 0xff;
+    next[10] ^= 0x01;
+    next[12] ^= 0x02;
+    next[200] ^= 0x04;
+    next[299] ^= 0x08;
+    delta.clear();
+    RewindBuffer::encode_delta(previous, next, sizeof(previous), delta);
+    this->assert_equal(delta[0], 0x00);
+    this->assert_equal(delta[1], 0x01);
+    this->assert_equal(delta[2], 0xff);
+    this->assert_equal(delta[3], 0x09);
+    this->assert_equal(delta[4], 0x03);
+    this->assert_equal(delta[5], 0x01);
+    this->assert_equal(delta[6], 0x00);
+    this->assert_equal(delta[7], 0x02);
+
+    // Delta turns either buffer into the other
+    uint8_t decoded[300];
+    memcpy(decoded, previous, sizeof(decoded));
+    RewindBuffer::apply_delta(delta, decoded, sizeof(decoded));
+    this->assert(memcmp(decoded, next, sizeof(decoded)) == 0);
+    RewindBuffer::apply_delta(delta, decoded, sizeof(decoded));
+    this->assert(memcmp(decoded, previous, sizeof(decoded)) == 0);
+
+    // Each rewind steps back one snapshot, to the state it was taken at
+    const unsigned int snapshot_count = 8;
+    GameBoy *gameboy = new GameBoy();
+    RewindBuffer rewind_buffer(gameboy, 1, 64 * 1024 * 1024);
+    uint64_t hashes[snapshot_count + 1];
+    rewind_buffer.capture();
+    hashes[0] = gameboy->hash_state();
+    for (unsigned int snapshot = 1; snapshot <= snapshot_count; snapshot ++)
+    {
+        gameboy->run_frame();
+        rewind_buffer.frame();
+        hashes[snapshot] = gameboy->hash_state();
+    }
+    this->assert_equal(rewind_buffer.get_snapshot_count(), snapshot_count);
+    for (unsigned int steps = 1; steps <= snapshot_count; steps ++)
+    {
+        this->assert(rewind_buffer.rewind());
+        this->assert(gameboy->hash_state() == hashes[snapshot_count - steps]);
+    }
+    // Oldest snapshot is restored once there is none before it
+    this->assert(! rewind_buffer.rewind());
+    this->assert(gameboy->hash_state() == hashes[0]);
+    delete gameboy;
+}
+
+void TestRunner::test_movie()
+{
+    std::cout << "movie";
+
+    char path[] = "/tmp/gameboy_test_movie_XXXXXX";
+    int fd = mkstemp(path);
+    if (! this->assert(fd != -1))
+        return;
+    close(fd);
+
+    // Press and release A between frames, with actions selected, which
+    // raises the joypad interrupt although A is never held during a frame
+    GameBoy *gameboy = new GameBoy();
+    gameboy->get_ram()->set(0xff00, 0x10);
+    Movie recording;
+    recording.start_recording(gameboy, 1);
+    for (unsigned int frame = 0; frame < 4; frame ++)
+    {
+        recording.start_frame();
+        gameboy->run_frame();
+        recording.end_frame();
+        if (frame == 1)
+        {
+            gameboy->get_joypad()->set_button(JoypadButton::JOYPAD_A, true);
+            gameboy->get_joypad()->set_button(JoypadButton::JOYPAD_A, false);
+        }
+    }
+    this->assert(recording.finish_recording(path));
+    this->assert_equal(recording.get_frame_count(), 4);
+    delete gameboy;
+
+    gameboy = new GameBoy();
+    Movie replay;
+    this->assert(replay.load(path));
+    this->assert(replay.start_replay(gameboy));
+    while (true)
+    {
+        replay.start_frame();
+        if (! gameboy->run_frame())
+            break;
+        replay.end_frame();
+    }
+    this->assert(replay.finish_replay());
+    delete gameboy;
+    unlink(path);
+}
@@ -9,6 +9,11 @@
 #include "./ram.h"
 #include "./cpu.h"
 #include "./vpu.h"
+#include "./frame_hasher.h"
+#include "./joypad.h"
+#include "./apu.h"
+#include "./rewind_buffer.h"
+#include "./movie.h"
 
 class TestRunner
 {
@@ -18,6 +23,11 @@ public:
     VPU* vpu_inst;
     RAM* ram_inst;
     void run_tests();
+    void test_frame_hash();
+    void test_joypad();
+    void test_apu();
+    void test_rewind();
+    void test_movie();
     void test_00();
     void test_01();
     void test_02();
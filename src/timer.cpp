@@ -0,0 +1,147 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+#include "timer.h"
+
+Timer::Timer(RAM *ram, Scheduler *scheduler, InterruptController *interrupts)
+{
+    this->ram = ram;
+    this->scheduler = scheduler;
+    this->interrupts = interrupts;
+
+    this->tac = 0;
+    this->tma = 0;
+    this->divider_base_cycle = this->scheduler->get_cycle();
+    this->tima_base_value = 0;
+    this->tima_base_cycle = this->divider_base_cycle;
+
+    this->ram->register_io_handler(this->DIV_ADDR, this);
+    this->ram->register_io_handler(this->TIMA_ADDR, this);
+    this->ram->register_io_handler(this->TMA_ADDR, this);
+    this->ram->register_io_handler(this->TAC_ADDR, this);
+}
+
+bool Timer::is_enabled()
+{
+    return (this->tac & this->TAC_ENABLE) != 0;
+}
+
+uint64_t Timer::get_period()
+{
+    return this->TIMA_PERIODS[this->tac & 0x03];
+}
+
+uint16_t Timer::get_divider_counter()
+{
+    return (uint16_t)(this->scheduler->get_cycle() - this->divider_base_cycle);
+}
+
+uint8_t Timer::get_tima()
+{
+    if (! this->is_enabled())
+        return this->tima_base_value;
+
+    // Count falling edges of the selected divider bit since the base cycle
+    uint64_t period = this->get_period();
+    uint64_t edges = ((this->scheduler->get_cycle() - this->divider_base_cycle) / period) -
+                     ((this->tima_base_cycle - this->divider_base_cycle) / period);
+    return (uint8_t)(this->tima_base_value + edges);
+}
+
+void Timer::rebase()
+{
+    this->tima_base_value = this->get_tima();
+    this->tima_base_cycle = this->scheduler->get_cycle();
+}
+
+void Timer::schedule_overflow()
+{
+    if (! this->is_enabled())
+    {
+        this->scheduler->cancel(SchedulerEvent::EVENT_TIMER);
+        return;
+    }
+
+    // Overflow occurs on the edge that increments TIMA past 0xff
+    uint64_t period = this->get_period();
+    uint64_t edges_to_overflow = 0x100 - this->tima_base_value;
+    uint64_t base_edge = (this->tima_base_cycle - this->divider_base_cycle) / period;
+    this->scheduler->schedule(SchedulerEvent::EVENT_TIMER,
+        this->divider_base_cycle + ((base_edge + edges_to_overflow) * period));
+}
+
+void Timer::overflow_event()
+{
+    this->tima_base_value = this->tma;
+    this->tima_base_cycle = this->scheduler->get_cycle();
+    this->interrupts->raise(InterruptType::INTERRUPT_TIMER);
+    this->schedule_overflow();
+}
+
+uint8_t Timer::io_read(uint16_t address, uint8_t stored_val)
+{
+    if (address == this->DIV_ADDR)
+        return (uint8_t)(this->get_divider_counter() >> 8);
+    if (address == this->TIMA_ADDR)
+        return this->get_tima();
+    if (address == this->TAC_ADDR)
+        return (uint8_t)(0xf8 | this->tac);
+    return stored_val;
+}
+
+void Timer::io_write(uint16_t address, uint8_t val)
+{
+    if (address == this->TMA_ADDR)
+    {
+        // Used on next overflow
+        this->tma = val;
+        return;
+    }
+
+    this->rebase();
+
+    if (address == this->DIV_ADDR)
+    {
+        // Any write resets the divider counter. If the selected bit
+        // was set, this is a falling edge, which increments TIMA.
+        bool falling_edge = this->is_enabled() && (this->get_divider_counter() & (this->get_period() / 2));
+        this->divider_base_cycle = this->scheduler->get_cycle();
+        this->tima_base_cycle = this->divider_base_cycle;
+
+        if (falling_edge && ++ this->tima_base_value == 0)
+        {
+            this->overflow_event();
+            return;
+        }
+    }
+    else if (address == this->TIMA_ADDR)
+    {
+        this->tima_base_value = val;
+    }
+    else if (address == this->TAC_ADDR)
+    {
+        this->tac = val & 0x07;
+    }
+
+    this->schedule_overflow();
+}
+
+void Timer::save_state(timer_state_t &state)
+{
+    state.tac = this->tac;
+    state.tma = this->tma;
+    state.tima_base_value = this->tima_base_value;
+    state.divider_base_cycle = this->divider_base_cycle;
+    state.tima_base_cycle = this->tima_base_cycle;
+}
+
+void Timer::load_state(const timer_state_t &state)
+{
+    this->tac = state.tac;
+    this->tma = state.tma;
+    this->tima_base_value = state.tima_base_value;
+    this->divider_base_cycle = state.divider_base_cycle;
+    this->tima_base_cycle = state.tima_base_cycle;
+}
@@ -0,0 +1,72 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+#pragma once
+
+#include <memory>
+#include "ram.h"
+#include "io_handler.h"
+#include "scheduler.h"
+#include "interrupt_controller.h"
+
+// Saved state of timer registers. A pending overflow
+// is restored with the scheduler.
+struct timer_state_t {
+    uint8_t tac;
+    uint8_t tma;
+    uint8_t tima_base_value;
+    uint64_t divider_base_cycle;
+    uint64_t tima_base_cycle;
+};
+
+// Divider and timer registers (DIV, TIMA, TMA, TAC).
+// DIV and TIMA are derived from the global cycle counter when read,
+// rather than being incremented each cycle. Only the TIMA overflow
+// is scheduled, and register writes re-base the derived state.
+class Timer : public IoHandler {
+public:
+    Timer(RAM *ram, Scheduler *scheduler, InterruptController *interrupts);
+
+    uint8_t io_read(uint16_t address, uint8_t stored_val);
+    void io_write(uint16_t address, uint8_t val);
+
+    // TIMA has overflowed - reload from TMA and raise interrupt
+    void overflow_event();
+
+    void save_state(timer_state_t &state);
+    void load_state(const timer_state_t &state);
+
+private:
+    const uint16_t DIV_ADDR = 0xff04;
+    const uint16_t TIMA_ADDR = 0xff05;
+    const uint16_t TMA_ADDR = 0xff06;
+    const uint16_t TAC_ADDR = 0xff07;
+    const uint8_t TAC_ENABLE = 0x04;
+
+    // Cycles per TIMA increment for each TAC clock select,
+    // being falling edges of bits 9, 3, 5 and 7 of the divider counter
+    const uint64_t TIMA_PERIODS[4] = {1024, 16, 64, 256};
+
+    RAM *ram;
+    Scheduler *scheduler;
+    InterruptController *interrupts;
+
+    uint8_t tac;
+    uint8_t tma;
+    // Cycle at which the divider counter was last reset
+    uint64_t divider_base_cycle;
+    // TIMA value at the base cycle, which increments from
+    // then on whilst the timer is enabled
+    uint8_t tima_base_value;
+    uint64_t tima_base_cycle;
+
+    bool is_enabled();
+    uint64_t get_period();
+    uint16_t get_divider_counter();
+    uint8_t get_tima();
+    // Store current TIMA value, so that timer settings can change
+    void rebase();
+    void schedule_overflow();
+};
@@ -0,0 +1,13 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+#pragma once
+
+// DMG CPU clock, in cycles per second
+#define CPU_CLOCK_HZ 4194304
+// Cycles per frame, for a refresh rate of 4194304 / 70224 = ~59.73Hz
+#define FRAME_CYCLES 70224
+// Host time per frame, in nanoseconds (~16.74ms)
+#define FRAME_DURATION_NS (FRAME_CYCLES * 1000000000LL / CPU_CLOCK_HZ)
@@ -0,0 +1,59 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+#pragma once
+
+#include <memory>
+#include <atomic>
+
+// Lock-free triple buffer for passing completed items (e.g. frames) from
+// a single producer thread to a single consumer thread.
+// The producer always has a buffer to write to and the consumer always
+// has the latest completed buffer to read from, so neither waits on the
+// other. Completed items are dropped if the consumer does not keep up.
+template <typename T>
+class TripleBuffer {
+public:
+    TripleBuffer() : middle_state(1), back(2), front(0) {};
+
+    // Producer - buffer to write next item into
+    T* get_write_buffer() {
+        return &this->buffers[this->back];
+    };
+    // Producer - mark write buffer as complete, swapping
+    // it with the middle buffer
+    void publish() {
+        uint8_t previous = this->middle_state.exchange(
+            (uint8_t)(this->back | this->DIRTY_FLAG), std::memory_order_acq_rel);
+        this->back = previous & this->INDEX_MASK;
+    };
+
+    // Consumer - obtain latest completed buffer, if one has been
+    // published since the last call
+    bool consume() {
+        if ((this->middle_state.load(std::memory_order_relaxed) & this->DIRTY_FLAG) == 0)
+            return false;
+        uint8_t previous = this->middle_state.exchange(this->front, std::memory_order_acq_rel);
+        this->front = previous & this->INDEX_MASK;
+        return true;
+    };
+    // Consumer - buffer obtained by last successful consume
+    const T* get_read_buffer() {
+        return &this->buffers[this->front];
+    };
+
+private:
+    const uint8_t INDEX_MASK = 0x03;
+    const uint8_t DIRTY_FLAG = 0x04;
+
+    T buffers[3];
+    // Index of middle buffer, with flag set when it has been
+    // published and not yet consumed
+    std::atomic<uint8_t> middle_state;
+    // Only accessed by the producer
+    uint8_t back;
+    // Only accessed by the consumer
+    uint8_t front;
+};
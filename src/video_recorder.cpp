@@ -0,0 +1,187 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+#include "video_recorder.h"
+
+#include <iostream>
+#include <chrono>
+#include <string.h>
+#include <signal.h>
+
+// Time writer thread waits, when there are no frames queued
+#define VIDEO_WRITER_WAIT_MS 1
+
+VideoRecorder::VideoRecorder()
+{
+    this->output = nullptr;
+    this->is_pipe = false;
+    this->format = VideoFormat::VIDEO_RAW_RGB;
+    this->interval = 1;
+    this->frames_since_write = 0;
+    this->stop_requested = false;
+    this->frames_written = 0;
+    this->frames_dropped = 0;
+    this->write_failed = false;
+    for (unsigned int itx = 0; itx < VIDEO_QUEUE_FRAMES; itx ++)
+        this->frames[itx] = nullptr;
+}
+
+VideoRecorder::~VideoRecorder()
+{
+    this->finish();
+    for (unsigned int itx = 0; itx < VIDEO_QUEUE_FRAMES; itx ++)
+        delete this->frames[itx];
+}
+
+VideoFormat VideoRecorder::get_format(const char *path)
+{
+    const char *extension = strrchr(path, '.');
+    if (extension != nullptr && strcmp(extension, ".y4m") == 0)
+        return VideoFormat::VIDEO_Y4M;
+    return VideoFormat::VIDEO_RAW_RGB;
+}
+
+bool VideoRecorder::start(const char *path, unsigned int interval)
+{
+    this->interval = interval ? interval : 1;
+    this->format = VideoRecorder::get_format(path);
+
+    if (path[0] == '|')
+    {
+        // Closed pipes are reported by failed writes, rather than a signal
+        signal(SIGPIPE, SIG_IGN);
+        this->output = popen(&path[1], "w");
+        this->is_pipe = true;
+    }
+    else
+    {
+        this->output = fopen(path, "wb");
+    }
+    if (this->output == nullptr)
+    {
+        std::cout << "Unable to open video output: " << path << std::endl;
+        return false;
+    }
+
+    if (this->format == VideoFormat::VIDEO_Y4M &&
+        fprintf(this->output, "YUV4MPEG2 W%d H%d F%u:%u Ip A1:1 C444\n",
+                SCREEN_PIXEL_WIDTH, SCREEN_PIXEL_HEIGHT,
+                (unsigned int)CPU_CLOCK_HZ, FRAME_CYCLES * this->interval) < 0)
+        this->write_failed = true;
+
+    for (unsigned int itx = 0; itx < VIDEO_QUEUE_FRAMES; itx ++)
+    {
+        this->frames[itx] = new frame_buffer_t;
+        this->free_frames.push(this->frames[itx]);
+    }
+
+    this->writer_thread = std::thread(&VideoRecorder::run, this);
+    return true;
+}
+
+void VideoRecorder::add_frame(const frame_buffer_t *frame)
+{
+    if (this->output == nullptr)
+        return;
+
+    // Only record every 'interval' frames
+    if (this->frames_since_write ++ % this->interval != 0)
+        return;
+
+    frame_buffer_t *copy;
+    if (! this->free_frames.pop(copy))
+    {
+        this->frames_dropped ++;
+        return;
+    }
+    memcpy(copy, frame, sizeof(frame_buffer_t));
+    this->queued_frames.push(copy);
+}
+
+void VideoRecorder::finish()
+{
+    if (this->output == nullptr)
+        return;
+
+    this->stop_requested = true;
+    this->writer_thread.join();
+
+    if (this->is_pipe)
+        pclose(this->output);
+    else if (fclose(this->output) != 0)
+        this->write_failed = true;
+    this->output = nullptr;
+
+    std::cout << "Video recording: " << std::dec << this->frames_written << " frames written, " <<
+        this->frames_dropped << " frames dropped" << std::endl;
+    if (this->write_failed)
+        std::cout << "Video recording failed to write to output" << std::endl;
+}
+
+void VideoRecorder::run()
+{
+    while (true)
+    {
+        frame_buffer_t *frame;
+        if (! this->queued_frames.pop(frame))
+        {
+            // Stop once all frames have been written
+            if (this->stop_requested)
+                return;
+            std::this_thread::sleep_for(std::chrono::milliseconds(VIDEO_WRITER_WAIT_MS));
+            continue;
+        }
+
+        // After a write error (e.g. encoder has exited), frames are discarded
+        if (! this->write_failed)
+        {
+            if (this->write_frame(frame))
+                this->frames_written ++;
+            else
+                this->write_failed = true;
+        }
+        this->free_frames.push(frame);
+    }
+}
+
+bool VideoRecorder::write_frame(const frame_buffer_t *frame)
+{
+    if (this->format == VideoFormat::VIDEO_Y4M)
+        return this->write_y4m_frame(frame);
+    return this->write_raw_rgb_frame(frame);
+}
+
+bool VideoRecorder::write_y4m_frame(const frame_buffer_t *frame)
+{
+    // Convert to BT.601 (limited range) Y, U and V planes
+    uint8_t *planes[3];
+    for (unsigned int plane = 0; plane < 3; plane ++)
+        planes[plane] = &this->output_buffer[plane * SCREEN_PIXEL_WIDTH * SCREEN_PIXEL_HEIGHT];
+    for (unsigned int itx = 0; itx < (SCREEN_PIXEL_WIDTH * SCREEN_PIXEL_HEIGHT); itx ++)
+    {
+        int r = (frame->pixels[itx] >> 16) & 0xff;
+        int g = (frame->pixels[itx] >> 8) & 0xff;
+        int b = frame->pixels[itx] & 0xff;
+        planes[0][itx] = (uint8_t)((((66 * r) + (129 * g) + (25 * b) + 128) >> 8) + 16);
+        planes[1][itx] = (uint8_t)((((-38 * r) - (74 * g) + (112 * b) + 128) >> 8) + 128);
+        planes[2][itx] = (uint8_t)((((112 * r) - (94 * g) - (18 * b) + 128) >> 8) + 128);
+    }
+
+    return fputs("FRAME\n", this->output) >= 0 &&
+        fwrite(this->output_buffer, sizeof(this->output_buffer), 1, this->output) == 1;
+}
+
+bool VideoRecorder::write_raw_rgb_frame(const frame_buffer_t *frame)
+{
+    uint8_t *rgb = this->output_buffer;
+    for (unsigned int itx = 0; itx < (SCREEN_PIXEL_WIDTH * SCREEN_PIXEL_HEIGHT); itx ++)
+    {
+        rgb[(itx * 3)] = (uint8_t)(frame->pixels[itx] >> 16);
+        rgb[(itx * 3) + 1] = (uint8_t)(frame->pixels[itx] >> 8);
+        rgb[(itx * 3) + 2] = (uint8_t)frame->pixels[itx];
+    }
+
+    return fwrite(this->output_buffer, sizeof(this->output_buffer), 1, this->output) == 1;
+}
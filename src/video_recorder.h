@@ -0,0 +1,76 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+#pragma once
+
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <stdio.h>
+
+#include "timing.h"
+#include "frame_buffer.h"
+#include "spsc_queue.h"
+
+// Number of frames that can be waiting to be written,
+// before frames are dropped
+#define VIDEO_QUEUE_FRAMES 16
+
+enum VideoFormat {
+    // YUV4MPEG2, 4:4:4, at the DMG frame rate
+    VIDEO_Y4M,
+    // Packed 24-bit RGB frames, without header
+    VIDEO_RAW_RGB
+};
+
+// Streams completed frames to a file or, when the path starts
+// with '|', to the stdin of a command (e.g. an encoder).
+// Frames are copied into a bounded queue on the emulation thread
+// and written on a writer thread. When the writer cannot keep
+// up, frames are dropped rather than stalling emulation.
+class VideoRecorder {
+public:
+    VideoRecorder();
+    ~VideoRecorder();
+
+    // Start recording, writing every 'interval' frames.
+    // The format is Y4M for .y4m paths, otherwise raw RGB.
+    bool start(const char *path, unsigned int interval);
+    // Write remaining frames and close the output
+    void finish();
+
+    // Emulation thread - called for each completed frame
+    void add_frame(const frame_buffer_t *frame);
+
+    static VideoFormat get_format(const char *path);
+
+private:
+
+    FILE *output;
+    bool is_pipe;
+    VideoFormat format;
+    unsigned int interval;
+    unsigned int frames_since_write;
+
+    // Unused frames are passed back to the emulation thread
+    // once written, so no allocation happens whilst recording
+    frame_buffer_t *frames[VIDEO_QUEUE_FRAMES];
+    SpscQueue<frame_buffer_t*, VIDEO_QUEUE_FRAMES> free_frames;
+    SpscQueue<frame_buffer_t*, VIDEO_QUEUE_FRAMES> queued_frames;
+
+    std::thread writer_thread;
+    std::atomic<bool> stop_requested;
+    uint64_t frames_written;
+    uint64_t frames_dropped;
+    bool write_failed;
+
+    // Converted frame, either as 3 planes or packed RGB
+    uint8_t output_buffer[SCREEN_PIXEL_WIDTH * SCREEN_PIXEL_HEIGHT * 3];
+
+    void run();
+    bool write_frame(const frame_buffer_t *frame);
+    bool write_y4m_frame(const frame_buffer_t *frame);
+    bool write_raw_rgb_frame(const frame_buffer_t *frame);
+};
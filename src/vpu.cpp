@@ -10,264 +10,324 @@
 #include "helper.h"
 #include <iostream>
 #include <unistd.h>
-// #include <string.h>
+#include <string.h>
 #include <memory>
+#include <cstdint>
 
 #define DEBUG 0
 
-VPU::VPU(RAM *ram) {
+VPU::VPU(RAM *ram, RuntimeStats *stats, Scheduler *scheduler, InterruptController *interrupts) {
     Helper::init();
     this->ram = ram;
-    SDL_Init(SDL_INIT_VIDEO);
-    this->window = SDL_CreateWindow("Gameboy Emu",
-        0, 0, this->SCREEN_WIDTH, this->SCREEN_HEIGHT, 0);
-    this->renderer = SDL_CreateRenderer(this->window, -1, 0);
-    SDL_CreateWindowAndRenderer(this->SCREEN_HEIGHT, this->SCREEN_WIDTH, 0, &this->window, &this->renderer);
+    this->stats = stats;
+    this->scheduler = scheduler;
+    this->interrupts = interrupts;
+    this->framebuffer = this->frame_buffers.get_write_buffer()->pixels;
+    this->last_frame = this->frame_buffers.get_write_buffer();
+    this->video_recorder = nullptr;
+    this->frame_hasher = nullptr;
+    this->frame_count = 0;
+
+    this->line_sprite_count = 0;
+    this->window_line = 0;
+
+    // LY and STAT are derived from the current mode, when read,
+    // and LCD control writes can turn the LCD on/off
+    this->ram->register_io_handler(this->ram->LCDC_LY_ADDR, this);
+    this->ram->register_io_handler(this->ram->LCDC_STATUS_ADDR, this);
+    this->ram->register_io_handler(this->ram->LCDC_CONTROL_ADDR, this);
+
+    // Reset control address value, which starts the first frame
+    this->lcd_on = false;
+    this->render_frame = true;
+    this->ram->set(this->ram->LCDC_CONTROL_ADDR, 0x91);
 
+    // Setup palettes, which are rebuilt when palette registers are written
+    this->ram->register_io_handler(this->ram->LCDC_BGP_ADDR, this);
+    this->ram->register_io_handler(this->ram->LCDC_OBP0_ADDR, this);
+    this->ram->register_io_handler(this->ram->LCDC_OBP1_ADDR, this);
+    this->set_color_scheme(COLOR_SCHEME_GREY);
 
-    this->mode_timer_itx = 0;
+    // Clear screen to lightest colour
+    for (unsigned int itx = 0; itx < (this->SCREEN_WIDTH * this->SCREEN_HEIGHT); itx ++)
+        this->framebuffer[itx] = this->color_scheme[0];
+    this->publish_frame();
+}
 
-    // Reset current line
-    this->ram->set(this->ram->LCDC_LY_ADDR, 0x00);
-    this->current_lx = 0;
+void VPU::capture_screenshot(const char* file_path)
+{
+    // Copy the last completed frame, which is encoded
+    // and written on the screenshot writer thread
+    this->screenshots.capture(file_path, this->last_frame, this->color_scheme);
+}
 
-    // Reset control address value
-    this->ram->set(this->ram->LCDC_CONTROL_ADDR, 0x91);
+TripleBuffer<frame_buffer_t>* VPU::get_frame_buffers()
+{
+    return &this->frame_buffers;
+}
 
-	//Create Window
+void VPU::publish_frame()
+{
+    // Hand completed frame over for presentation and start
+    // drawing into the next free buffer
+    this->last_frame = this->frame_buffers.get_write_buffer();
+    this->frame_buffers.publish();
+    this->framebuffer = this->frame_buffers.get_write_buffer()->pixels;
+
+    if (this->video_recorder != nullptr)
+        this->video_recorder->add_frame(this->last_frame);
+    if (this->frame_hasher != nullptr)
+        this->frame_hasher->add_frame(this->frame_count, this->last_frame);
+}
 
-    // Clear with white
-    SDL_SetRenderDrawColor(this->renderer, 255, 255, 255, 0);
-    SDL_RenderClear(this->renderer);
-    SDL_RenderPresent(this->renderer);
-    SDL_SetRenderDrawColor(this->renderer, 0, 0, 0, 0);
-    // Set all pixels to black
-    for (unsigned int x = 0; x < this->SCREEN_WIDTH; x++)
-        for (unsigned int y = 0; y < this->SCREEN_HEIGHT; y++)
-                SDL_RenderDrawPoint(this->renderer, (int)y, (int)x);
+void VPU::save_state(vpu_state_t &state)
+{
+    state.current_mode = (uint8_t)this->current_mode;
+    state.current_ly = (uint8_t)this->current_ly;
+    state.lcd_on = this->lcd_on;
+    state.render_frame = this->render_frame;
+    state.window_line = this->window_line;
+    state.next_event_cycle = this->next_event_cycle;
+    state.frame_count = this->frame_count;
+    memcpy(state.line_sprites, this->line_sprites, sizeof(state.line_sprites));
+    state.line_sprite_count = this->line_sprite_count;
+    memcpy(state.frame.pixels, this->framebuffer, sizeof(state.frame.pixels));
+}
 
+void VPU::load_state(const vpu_state_t &state)
+{
+    this->current_mode = (MODE)state.current_mode;
+    this->current_ly = state.current_ly;
+    this->lcd_on = state.lcd_on;
+    this->render_frame = state.render_frame;
+    this->window_line = state.window_line;
+    this->next_event_cycle = state.next_event_cycle;
+    this->frame_count = state.frame_count;
+    memcpy(this->line_sprites, state.line_sprites, sizeof(this->line_sprites));
+    this->line_sprite_count = state.line_sprite_count;
+    memcpy(this->framebuffer, state.frame.pixels, sizeof(state.frame.pixels));
+
+    // Publish restored frame, so that it is displayed and captured rather
+    // than the frame from before the load, and keep drawing on top of it
+    this->last_frame = this->frame_buffers.get_write_buffer();
+    this->frame_buffers.publish();
+    this->framebuffer = this->frame_buffers.get_write_buffer()->pixels;
+    memcpy(this->framebuffer, state.frame.pixels, sizeof(state.frame.pixels));
+
+    // Host colours are derived from the palette registers
+    this->update_palette(PALETTE_BG, this->ram->get_val(this->ram->LCDC_BGP_ADDR));
+    this->update_palette(PALETTE_OBP0, this->ram->get_val(this->ram->LCDC_OBP0_ADDR));
+    this->update_palette(PALETTE_OBP1, this->ram->get_val(this->ram->LCDC_OBP1_ADDR));
+}
 
-    SDL_SetRenderDrawColor(this->renderer, 0, 255, 0, 0);
-    // Set all pixels to black
-    for (unsigned int x = 60; x < 80; x++)
-        for (unsigned int y = 50; y < 90; y++)
-                SDL_RenderDrawPoint(this->renderer, (int)x, (int)y);
-    SDL_RenderPresent(this->renderer);
+void VPU::set_video_recorder(VideoRecorder *video_recorder)
+{
+    this->video_recorder = video_recorder;
 }
 
-void VPU::capture_screenshot(char* file_path)
+void VPU::set_frame_hasher(FrameHasher *frame_hasher)
 {
-    int w, h;
-    SDL_GetRendererOutputSize(this->renderer, &w, &h);
-    SDL_Surface *sshot = SDL_CreateRGBSurface(0, w, h, 32, 0x00ff0000, 0x0000ff00, 0x000000ff, 0xff000000);
-    SDL_RenderReadPixels(this->renderer, NULL, SDL_PIXELFORMAT_ARGB8888, sshot->pixels, sshot->pitch);
-    SDL_SaveBMP(sshot, file_path);
-    SDL_FreeSurface(sshot);
+    this->frame_hasher = frame_hasher;
 }
 
-void VPU::redraw()
+void VPU::set_color_scheme(const uint32_t colors[4])
 {
-    // Redraw SDL
-    SDL_RenderPresent(this->renderer);
-}
-
-VpuEventType VPU::process_events() {   
-    // Handle SDL events
-    SDL_Event event;
-    while(SDL_PollEvent(&event) != 0) {
-
-        switch(event.type) {
-            case SDL_WINDOWEVENT:
-                if (event.window.event == SDL_WINDOWEVENT_CLOSE) {
-                    return VpuEventType::EXIT;
-                }
-                break;
-
-            case SDL_QUIT:
-                return VpuEventType::EXIT;
-            
-            // Check for keyboard events
-            case SDL_KEYDOWN:
-                switch(event.key.keysym.sym) {
-                    case SDLK_ESCAPE:
-                        return VpuEventType::EXIT;
-                }
-        }
-    }
-    return VpuEventType::NONE;
+    for (unsigned int shade = 0; shade < 4; shade ++)
+        this->color_scheme[shade] = colors[shade];
+
+    this->update_palette(PALETTE_BG, this->ram->get_val(this->ram->LCDC_BGP_ADDR));
+    this->update_palette(PALETTE_OBP0, this->ram->get_val(this->ram->LCDC_OBP0_ADDR));
+    this->update_palette(PALETTE_OBP1, this->ram->get_val(this->ram->LCDC_OBP1_ADDR));
 }
 
-// VPU ticks happen at ~ 4213440Hz - 4.213KHz
-// CPU ticks will be limited to 1MHz
-void VPU::update_mode_flag()
+void VPU::update_palette(unsigned int palette, uint8_t palette_data)
 {
-    uint8_t mode;
-    // Check for v-blank - since ly starts at 0 and screen height starts at
-    // 1, check greater than or equal to
-    if (this->get_ly() >= this->SCREEN_HEIGHT)
-    {
-        this->current_mode = this->MODE::MODE1;
-        
-        // Set mode timer from start of blank (x * y since vblank start)
-        this->mode_timer_itx = ((this->get_ly() - this->SCREEN_HEIGHT) * SCREEN_WIDTH) + this->get_lx();
+    // Each 2 bits of the palette register gives the shade
+    // for a colour index, which is mapped directly to
+    // the host colour
+    for (unsigned int color = 0; color < 4; color ++)
+        this->palette_colors[palette][color] = this->color_scheme[(palette_data >> (color * 2)) & 0x03];
+}
 
-        // Set bit 0+1 to 1
-        mode = 0x01;
-    }
-    // Check for OAM transfer
-    else if (this->get_lx() < this->MODE2_LENGTH)
+VpuEventType VPU::process_event()
+{
+    VpuEventType return_val = VpuEventType::NONE;
+
+    switch (this->current_mode)
     {
-        this->current_mode = this->MODE::MODE2;
-        this->mode_timer_itx = this->get_lx();
-        // Set bit 0+1 to 2
-        mode = 0x02;
+        case MODE::MODE2:
+            // OAM scan complete, start pixel transfer,
+            // drawing the entire line
+            this->current_mode = MODE::MODE3;
+            this->next_event_cycle += this->MODE3_LENGTH;
+            if (this->render_frame)
+                this->render_line();
+            break;
+
+        case MODE::MODE3:
+            // Enter H-blank
+            this->current_mode = MODE::MODE0;
+            this->next_event_cycle += this->MODE0_LENGTH;
+            if (this->ram->get_ram_bit(this->ram->LCDC_STATUS_ADDR, 3) == 1)
+                this->trigger_stat_interrupt();
+            break;
+
+        case MODE::MODE0:
+            this->current_ly ++;
+            if (this->current_ly == this->SCREEN_HEIGHT)
+                return_val = this->start_vblank();
+            else
+                this->start_line();
+            break;
+
+        case MODE::MODE1:
+            // Each line of V-blank takes the same time as a drawn line,
+            // then return to top of screen
+            this->current_ly ++;
+            if (this->current_ly > this->MAX_LY)
+            {
+                this->current_ly = 0;
+                if (DEBUG)
+                    std::cout << "NEXT SCREEN CYCLE" << std::endl;
+                this->start_line();
+            }
+            else
+            {
+                this->next_event_cycle += this->H_LENGTH;
+                this->check_lyc_interrupt();
+            }
+            break;
     }
-    // Check for LCD transfer
-    else if (this->get_lx() < (this->MODE2_LENGTH + this->MODE3_LENGTH))
+
+    this->scheduler->schedule(SchedulerEvent::EVENT_VPU, this->next_event_cycle);
+    return return_val;
+}
+
+void VPU::start_line()
+{
+    // Determine whether frame should be drawn, at the start of each frame
+    if (this->current_ly == 0)
+        this->render_frame = this->frame_skip.should_render(
+            this->next_event_cycle + (this->SCREEN_HEIGHT * this->H_LENGTH));
+
+    // Start OAM scan for the line
+    this->current_mode = MODE::MODE2;
+    this->next_event_cycle += this->MODE2_LENGTH;
+
+    this->check_lyc_interrupt();
+
+    if (this->ram->get_ram_bit(this->ram->LCDC_STATUS_ADDR, 5) == 1)
+        this->trigger_stat_interrupt();
+
+    // Select sprites for the line, which are then
+    // used for each pixel drawn in mode 3
+    if (this->render_frame)
+        this->scan_oam();
+}
+
+VpuEventType VPU::start_vblank()
+{
+    this->current_mode = MODE::MODE1;
+    this->next_event_cycle += this->H_LENGTH;
+
+    this->check_lyc_interrupt();
+
+    // Publish frame at beginning of v-blank
+    if (this->render_frame)
     {
-        this->current_mode = this->MODE::MODE3;
-        this->mode_timer_itx = this->get_lx() - this->MODE2_LENGTH;
-        // Set bits 0+1 to 3
-        mode = 0x03;
+        this->publish_frame();
+        RuntimeStats::add(this->stats->frames_rendered);
     }
-    // Default to H-blank
     else
     {
-        this->current_mode = this->MODE::MODE0;
-        this->mode_timer_itx = this->get_lx() - (this->MODE2_LENGTH + this->MODE3_LENGTH);
-        // Set bits 0+1 to 0
-        mode = 0x00;
-    }
-    
-    if (this->get_ly() == this->ram->get_val(this->ram->LCDC_LYC_ADDR))
-    {
-        // Set bit 2
-        mode |= 0x04;
+        RuntimeStats::add(this->stats->frames_skipped);
     }
 
-    uint8_t current_mode = this->ram->get_val(this->ram->LCDC_STATUS_ADDR);
-    
-    // Blank out bits 0-2
-    current_mode &= 0x07;
-    
-    // Combine new mode flags with remainder of original flag
-    current_mode |= mode;
-    
-    this->ram->set(this->ram->LCDC_STATUS_ADDR, current_mode);
+    // Window line counter restarts for each frame
+    this->window_line = 0;
+    this->frame_count ++;
+
+    // Trigger v-blank interrupt
+    this->interrupts->raise(InterruptType::INTERRUPT_VBLANK);
+
+    // Check if STAT interrupt should be set on first tick
+    if (this->ram->get_ram_bit(this->ram->LCDC_STATUS_ADDR, 4) == 1)
+        this->trigger_stat_interrupt();
+
+    return VpuEventType::VBLANK;
 }
 
-void VPU::increment_lx_ly()
+void VPU::check_lyc_interrupt()
 {
-    if (this->current_lx == this->MAX_LX)
+    // Check LYC=LY coincide interrupt at the start of each line
+    if (this->current_ly == this->ram->get_val(this->ram->LCDC_LYC_ADDR) &&
+        this->ram->get_ram_bit(this->ram->LCDC_STATUS_ADDR, 6) == 1)
     {
-        this->current_lx = 0;
-        // If LX 'overflowed', increment
-        // LY
-        uint8_t new_ly = this->get_ly();
-        if (new_ly == this->MAX_LY)
-        {
-            new_ly = 0;
-            if (DEBUG)
-                std::cout << "NEXT SCREEN CYCLE" << std::endl;
-        }
-        else
-        {
-            new_ly ++;
-        }
-        this->ram->set(this->ram->LCDC_LY_ADDR, new_ly);
-    }
-    else
-    {
-        this->current_lx ++;
+        this->trigger_stat_interrupt();
     }
 }
 
 void VPU::trigger_stat_interrupt()
 {
-    this->ram->set_ram_bit(this->ram->INTERRUPT_IF_REGISTER_ADDRESS, 1, 1U);
+    this->interrupts->raise(InterruptType::INTERRUPT_STAT);
 }
 
-
-
-VpuEventType VPU::tick()
+uint64_t VPU::get_frame_count()
 {
-    VpuEventType return_val = VpuEventType::NONE;
-
-    // Increment lx
-    this->increment_lx_ly();
-
-    this->update_mode_flag();
+    return this->frame_count;
+}
 
-    // Check current mode
-    if (this->current_mode == this->MODE::MODE2)
+uint8_t VPU::io_read(uint16_t address, uint8_t stored_val)
+{
+    if (address == this->ram->LCDC_LY_ADDR)
+        return this->get_ly();
+    if (address != this->ram->LCDC_STATUS_ADDR)
+        return stored_val;
+
+    // STAT - mode and coincidence flag are derived from current state,
+    // with the interrupt selection bits from the stored value
+    uint8_t stat = (uint8_t)(0x80 | (stored_val & 0x78));
+    if (this->lcd_on)
     {
-        // Check for interrupts
-        if (this->mode_timer_itx == 0)
-        {
-            // Since this is the first mode for a line draw line,
-            // check LYC=LY coincide interrupt
-            if (this->get_ly() == this->ram->get_val(this->ram->LCDC_LYC_ADDR) &&
-                this->ram->get_ram_bit(this->ram->LCDC_STATUS_ADDR, 6) == 1)
-            {
-                this->trigger_stat_interrupt();
-            }
-
-            // Check if STAT interrupt should be set on first tick
-            if (this->ram->get_ram_bit(this->ram->LCDC_STATUS_ADDR, 5) == 1)
-            {
-                this->trigger_stat_interrupt();
-            }
-        }
-
-        // Do nothing
-        // In future, deal with OAM 
+        stat |= (uint8_t)this->current_mode;
+        if (this->current_ly == this->ram->get_val(this->ram->LCDC_LYC_ADDR))
+            stat |= 0x04;
     }
-    else if (this->current_mode == this->MODE::MODE3)
-    {
-        // Check if LCD is enabled
-        if (! this->lcd_enabled())
-            return return_val;
+    return stat;
+}
 
-        // Draw pixels
-        if (this->mode_timer_itx < this->SCREEN_WIDTH)
-        {
-            this->current_draw_pixel = this->mode_timer_itx;
-            this->process_pixel();
-        }
-    }
-    else if (this->current_mode == this->MODE::MODE0)
+void VPU::io_write(uint16_t address, uint8_t val)
+{
+    if (address == this->ram->LCDC_BGP_ADDR)
+        this->update_palette(PALETTE_BG, val);
+    else if (address == this->ram->LCDC_OBP0_ADDR)
+        this->update_palette(PALETTE_OBP0, val);
+    else if (address == this->ram->LCDC_OBP1_ADDR)
+        this->update_palette(PALETTE_OBP1, val);
+    if (address != this->ram->LCDC_CONTROL_ADDR)
+        return;
+
+    bool enable = (val & 0x80) != 0;
+    if (enable == this->lcd_on)
+        return;
+    this->lcd_on = enable;
+
+    if (enable)
     {
-        // Check if STAT interrupt should be set on first tick
-        if (this->mode_timer_itx == 0 &&
-            this->ram->get_ram_bit(this->ram->LCDC_STATUS_ADDR, 3) == 1)
-        {
-            this->trigger_stat_interrupt();
-        }
-        // Do nothing in h-blank
+        // Start drawing from the top of the screen on the next cycle
+        this->current_ly = 0;
+        this->next_event_cycle = this->scheduler->get_cycle();
+        this->start_line();
+        this->scheduler->schedule(SchedulerEvent::EVENT_VPU, this->next_event_cycle);
     }
-    else if (this->current_mode == this->MODE::MODE1)
+    else
     {
-        // If timer is at 0, check for interrupts
-        if (this->mode_timer_itx == 0)
-        {
-            // Redraw at beginning of h-blank
-            this->redraw();
- 
-            // Handle SDL2 events
-            return_val = this->process_events();
-
-            // Trigger v-blank interrupt
-            this->ram->set_ram_bit(this->ram->INTERRUPT_IF_REGISTER_ADDRESS, 0, 1U);
-
-            // Check if STAT interrupt should be set on first tick
-            if (this->ram->get_ram_bit(this->ram->LCDC_STATUS_ADDR, 4) == 1)
-            {
-                this->trigger_stat_interrupt();
-            }
-        }
+        // LY is held at 0 and no mode transitions occur whilst the LCD is off
+        this->current_mode = MODE::MODE0;
+        this->current_ly = 0;
+        this->next_event_cycle = UINT64_MAX;
+        this->scheduler->cancel(SchedulerEvent::EVENT_VPU);
     }
-    
-    return return_val;
 }
 
 uint8_t VPU::get_background_scroll_y() {
@@ -277,153 +337,217 @@ uint8_t VPU::get_background_scroll_x() {
     return this->ram->get_val(this->ram->LCDC_SCX);
 }
 
-uint8_t VPU::lcd_enabled() {
-    //return 1;
-    return this->ram->get_ram_bit(this->ram->LCDC_CONTROL_ADDR, 0x07);
+uint8_t VPU::sprites_enabled() {
+    return this->ram->get_ram_bit(this->ram->LCDC_CONTROL_ADDR, 0x01);
+}
+
+uint8_t VPU::get_sprite_height() {
+    // Bit 2 selects between 8x8 and 8x16 sprites
+    return this->ram->get_ram_bit(this->ram->LCDC_CONTROL_ADDR, 0x02) ? 16 : 8;
 }
 
 uint8_t VPU::get_background_map() {
     return this->ram->get_ram_bit(this->ram->LCDC_CONTROL_ADDR, 0x03);
 }
+uint8_t VPU::background_enabled() {
+    return this->ram->get_ram_bit(this->ram->LCDC_CONTROL_ADDR, 0x00);
+}
+uint8_t VPU::window_enabled() {
+    return this->ram->get_ram_bit(this->ram->LCDC_CONTROL_ADDR, 0x05);
+}
+uint8_t VPU::get_window_map() {
+    return this->ram->get_ram_bit(this->ram->LCDC_CONTROL_ADDR, 0x06);
+}
 uint8_t VPU::get_background_data_type() {
     return this->ram->get_ram_bit(this->ram->LCDC_CONTROL_ADDR, 0x04);
 }
 
-vec_2d VPU::get_pixel_tile_position() {
-    vec_2d pos;
-    pos.x = ((unsigned int)((unsigned int)this->get_background_scroll_x() + (unsigned int)this->current_draw_pixel) % (this->TILE_WIDTH * this->BACKGROUND_TILE_GRID_WIDTH)) % this->TILE_WIDTH;
-    pos.y = (((unsigned int)this->get_background_scroll_y() + (unsigned int)this->get_ly())  %(this->TILE_HEIGHT * this->BACKGROUND_TILE_GRID_HEIGHT)) % this->TILE_HEIGHT;
-    return pos;
-}
-
-uint8_t VPU::get_pixel_color() {
-
-    vec_2d pos = this->get_pixel_tile_position();
-    // Get byte index, by determining where pixel is in the byte (which contains half a line of colours)
-    uint16_t byte_addr = (uint16_t)(
-        (unsigned long)this->get_current_tile_data_address() +
-         (pos.x / 4) + (pos.y * 2)
-    );
-    // Unset last bit of address to get lower byte
-    byte_addr &= (uint16_t)0xfffe;
-
-    // Get bit index of bytes, by getting the reverse order
-    unsigned int byte_index = (7 - pos.x);
-    // Obtain upper and lower bytes
-    uint8_t byte1 = this->ram->get_val(byte_addr);
-    uint8_t byte2 = this->ram->get_val(byte_addr | (uint16_t)0x0001);
-
-    // Get nth (byte_index) bit from both bytes and use one as lsb and second as msb
-    uint8_t colour_byte = ((uint8_t)((byte2 >> byte_index) & (uint8_t)(0x01)) |
-                           (uint8_t)((byte1 >> byte_index) & (uint8_t)(0x01) << 1));
-
-    if (DEBUG && (unsigned int)this->get_current_tile_data_address() == 0x83a0) {
-        std::cout << std::hex << "byte1: " << (unsigned int)byte1 << " byte2: " << (unsigned int)byte2 << std::endl;
-        std::cout << std::hex << "Colour Byte index: " << byte_index <<
-            " tile width: " << this->TILE_WIDTH <<
-            " tile y pos: " << pos.y << std::endl <<
-            " tile x pos: " << pos.x << std::endl <<
-            " bit1: " << (unsigned int)((byte1 >> byte_index) & (uint8_t)(0x01)) <<
-            " bit2: " << (unsigned int)((byte2 >> byte_index) & (uint8_t)(0x01) << 1) <<
-            "  x: " << (unsigned int)this->current_draw_pixel << ", y: " << (unsigned int)this->get_ly() << std::endl <<
-            " colour byte: " << (unsigned int)colour_byte <<
-            " tile index: " << byte_index <<
-            " Tile data location " << this->get_tile_data_address(this->ram->get_val(this->get_current_map_address())) <<
-            " Memory location: " << (unsigned int)byte_addr << std::endl;
-         std::cout << (unsigned int)this->get_tile_map_index_from_current_coord() << std::endl;
-         std::cout << (unsigned long)this->VRAM_BG_MAPS[this->get_background_map()] << std::endl;
-         std::cout << (unsigned long)this->get_tile_map_index_from_current_coord() << std::endl;
-         std::cout << std::hex << (unsigned int)this->get_current_map_address() << std::endl;
-         std::cout << (unsigned long)this->ram->get_val(this->get_current_map_address()) << std::endl;
-         std::cout << (unsigned int)this->ram->get_val(this->get_current_tile_data_address()) << std::endl;
-         //std::cin.get();
+void VPU::scan_oam() {
+    this->line_sprite_count = 0;
+
+    if (! this->sprites_enabled())
+        return;
+
+    unsigned int height = (unsigned int)this->get_sprite_height();
+    unsigned int line = (unsigned int)this->get_ly() + this->SPRITE_Y_OFFSET;
+
+    for (unsigned int sprite_itx = 0; sprite_itx < this->OAM_SPRITE_COUNT; sprite_itx ++)
+    {
+        uint16_t sprite_addr = this->OAM_ADDR + (sprite_itx * this->OAM_SPRITE_SIZE);
+        oam_sprite sprite;
+        sprite.y = this->ram->get_val(sprite_addr);
+
+        // Skip sprites that do not cover the current line
+        if (line < (unsigned int)sprite.y || line >= ((unsigned int)sprite.y + height))
+            continue;
+
+        sprite.x = this->ram->get_val(sprite_addr + 1);
+        sprite.tile = this->ram->get_val(sprite_addr + 2);
+        sprite.attributes = this->ram->get_val(sprite_addr + 3);
+
+        // Insert into list, ordered by X co-ordinate. Sprites with the same
+        // X co-ordinate keep OAM order, so the lower OAM index wins.
+        unsigned int insert_itx = this->line_sprite_count;
+        while (insert_itx > 0 && this->line_sprites[insert_itx - 1].x > sprite.x)
+        {
+            this->line_sprites[insert_itx] = this->line_sprites[insert_itx - 1];
+            insert_itx --;
+        }
+        this->line_sprites[insert_itx] = sprite;
+        this->line_sprite_count ++;
+
+        // Only the first 10 sprites (in OAM order) are drawn for each line
+        if (this->line_sprite_count == MAX_SPRITES_PER_LINE)
+            break;
     }
-    return colour_byte;
 }
 
-void VPU::tear_down() {
-    SDL_DestroyRenderer(this->renderer);
-    SDL_DestroyWindow(this->window);
-    SDL_Quit();
+uint8_t VPU::get_tile_pixel(uint16_t tile_line_address, unsigned int x) {
+    // Each tile line is 2 bytes, the first containing the lsb
+    // and the second containing the msb for each pixel, with
+    // the left-most pixel being bit 7.
+    unsigned int bit_index = 7 - x;
+    uint8_t lsb = this->ram->get_val(tile_line_address);
+    uint8_t msb = this->ram->get_val(tile_line_address + 1);
+    return (uint8_t)(((lsb >> bit_index) & 0x01) | (((msb >> bit_index) & 0x01) << 1));
 }
 
-void VPU::process_pixel() {
-    //
-    uint8_t color = this->get_pixel_color();
-    switch((unsigned int)color) {
-        case 0:
-            SDL_SetRenderDrawColor(renderer, 200, 200, 200, 0);
-            break;
-        case 1:
-            SDL_SetRenderDrawColor(renderer, 172, 172, 172, 0);
-            break;
-        case 3:
-            SDL_SetRenderDrawColor(renderer, 86, 86, 86, 0);
-            break;
-        case 2:
-            SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+bool VPU::get_sprite_pixel_color(unsigned int x, uint8_t background_color, uint32_t &sprite_color) {
+    unsigned int screen_x = x + this->SPRITE_X_OFFSET;
+    unsigned int line = (unsigned int)this->get_ly() + this->SPRITE_Y_OFFSET;
+    unsigned int height = (unsigned int)this->get_sprite_height();
+
+    for (unsigned int sprite_itx = 0; sprite_itx < this->line_sprite_count; sprite_itx ++)
+    {
+        oam_sprite &sprite = this->line_sprites[sprite_itx];
+
+        // Since sprites are ordered by X, once a sprite starts after
+        // the current pixel, so do all remaining sprites
+        if ((unsigned int)sprite.x > screen_x)
             break;
-        default:
-            // Random colour
-            SDL_SetRenderDrawColor(renderer, 255, 0, 128, 0);
-            //std::cout << std::hex << "Unknown color: " << (unsigned int)color << std::endl;
-    };
-    SDL_RenderDrawPoint(this->renderer, (int)this->current_draw_pixel, (int)this->get_ly());
-    //this->process_events();
-    //if (DEBUG && color != 0x0)
-    //    std::cout << std::hex << "Setting Pixel color: " << (unsigned int)this->current_draw_pixel << " " << (unsigned int)this->get_ly() << " " << (int)color << std::endl;
-}
-
-// Return the on-screen X coornidate of the pixel being drawn
-uint8_t VPU::get_lx() {
-    return this->current_lx;
-}
-// Return the on-screen X coornidate of the pixel being drawn
-uint8_t VPU::get_ly() {
-    return this->ram->get_val(this->ram->LCDC_LY_ADDR);
+        if (screen_x >= ((unsigned int)sprite.x + this->TILE_WIDTH))
+            continue;
+
+        unsigned int tile_x = screen_x - (unsigned int)sprite.x;
+        unsigned int tile_y = line - (unsigned int)sprite.y;
+        if (sprite.attributes & this->SPRITE_ATTR_X_FLIP)
+            tile_x = (this->TILE_WIDTH - 1) - tile_x;
+        if (sprite.attributes & this->SPRITE_ATTR_Y_FLIP)
+            tile_y = (height - 1) - tile_y;
+
+        // In 8x16 mode, the lowest bit of the tile number is ignored,
+        // with the bottom half of the sprite using the next tile
+        uint8_t tile = sprite.tile;
+        if (height == 16)
+            tile &= 0xfe;
+
+        uint8_t color = this->get_tile_pixel(
+            (uint16_t)(this->SPRITE_TILE_DATA_ADDR + ((unsigned int)tile * this->TILE_DATA_SIZE) + (tile_y * 2)),
+            tile_x);
+
+        // Colour 0 is transparent, so allow lower priority sprites to show
+        if (color == 0)
+            continue;
+
+        // Sprites with priority flag set are only drawn over background colour 0
+        if ((sprite.attributes & this->SPRITE_ATTR_PRIORITY) && background_color != 0)
+            return false;
+
+        sprite_color = this->palette_colors[(sprite.attributes & this->SPRITE_ATTR_PALETTE) ? PALETTE_OBP1 : PALETTE_OBP0][color];
+        return true;
+    }
+    return false;
 }
 
-uint8_t convert_int8_uint8(uint8_t in_val) {
-    union {
-        uint8_t uint8[2];
-        int8_t int8[2];
-    } data;
-    data.int8[0] = (int8_t)in_val;
-    return data.uint8[0];
-}
+void VPU::decode_map_row(uint8_t map, uint8_t y) {
+    // Decode an entire line of a 32x32 tile map into colour
+    // indexes, which are then copied into the line in spans
+    uint16_t map_row_address = (uint16_t)(this->VRAM_BG_MAPS[map] +
+        (((unsigned int)y / this->TILE_HEIGHT) * this->BACKGROUND_TILE_GRID_WIDTH));
+    unsigned int tile_line = (unsigned int)y % this->TILE_HEIGHT;
+
+    for (unsigned int tile_itx = 0; tile_itx < this->BACKGROUND_TILE_GRID_WIDTH; tile_itx ++)
+    {
+        uint16_t tile_line_address = (uint16_t)(
+            this->get_tile_data_address(this->ram->get_val(map_row_address + tile_itx)) + (tile_line * 2));
+        uint8_t lsb = this->ram->get_val(tile_line_address);
+        uint8_t msb = this->ram->get_val(tile_line_address + 1);
 
-unsigned int VPU::get_tile_map_index_from_current_coord() {
-    //if (this->current_draw_pixel() == 0)
-    //    std::cout << (unsigned int)this->VRAM_BG_MAPS[this->get_background_map()] << std::endl;
-    unsigned int bgs_y = (unsigned int)this->get_background_scroll_y();
-    unsigned int bgs_x = (unsigned int)this->get_background_scroll_x();
-    unsigned int y = (unsigned int)this->get_ly();
-    unsigned int x = (unsigned int)this->current_draw_pixel;
-    return (unsigned int)(((((bgs_y + y) % (this->TILE_HEIGHT * this->BACKGROUND_TILE_GRID_HEIGHT)) / this->TILE_HEIGHT) * this->BACKGROUND_TILE_GRID_WIDTH) +
-                          (((bgs_x + x) % (this->TILE_WIDTH * this->BACKGROUND_TILE_GRID_WIDTH)) / this->TILE_WIDTH));
+        uint8_t *dest = this->map_row + (tile_itx * this->TILE_WIDTH);
+        for (unsigned int bit_index = 0; bit_index < this->TILE_WIDTH; bit_index ++)
+        {
+            unsigned int shift = 7 - bit_index;
+            dest[bit_index] = (uint8_t)(((lsb >> shift) & 0x01) | (((msb >> shift) & 0x01) << 1));
+        }
+    }
 }
 
-uint16_t VPU::get_tile_data_address(uint8_t tile_number) {
-    uint8_t offset;
-    unsigned int mode = (unsigned int)this->get_background_data_type();
-    if (mode) {
-        offset = (uint8_t)((tile_number & 0x80) ? (tile_number - 128) : tile_number);
+void VPU::render_line() {
+    unsigned int ly = (unsigned int)this->get_ly();
+
+    if (this->background_enabled())
+    {
+        // Copy visible part of background, wrapping around the end of the map
+        this->decode_map_row(this->get_background_map(), (uint8_t)(ly + (unsigned int)this->get_background_scroll_y()));
+        unsigned int scroll_x = (unsigned int)this->get_background_scroll_x();
+        unsigned int span = MAP_PIXEL_WIDTH - scroll_x;
+        if (span >= this->SCREEN_WIDTH)
+        {
+            memcpy(this->line_colors, this->map_row + scroll_x, this->SCREEN_WIDTH);
+        }
+        else
+        {
+            memcpy(this->line_colors, this->map_row + scroll_x, span);
+            memcpy(this->line_colors + span, this->map_row, this->SCREEN_WIDTH - span);
+        }
+
+        // Window is drawn over the background from WX-7 to the end of the line
+        unsigned int window_y = (unsigned int)this->ram->get_val(this->ram->LCDC_WY_ADDR);
+        unsigned int window_x = (unsigned int)this->ram->get_val(this->ram->LCDC_WX_ADDR);
+        if (this->window_enabled() && ly >= window_y && window_x < (this->SCREEN_WIDTH + this->WINDOW_X_OFFSET))
+        {
+            this->decode_map_row(this->get_window_map(), (uint8_t)this->window_line);
+            unsigned int source_x = 0;
+            unsigned int dest_x = 0;
+            if (window_x < this->WINDOW_X_OFFSET)
+                source_x = this->WINDOW_X_OFFSET - window_x;
+            else
+                dest_x = window_x - this->WINDOW_X_OFFSET;
+            memcpy(this->line_colors + dest_x, this->map_row + source_x, this->SCREEN_WIDTH - dest_x);
+
+            // Window line only advances on lines that the window is drawn
+            this->window_line ++;
+        }
     }
     else
-        offset = tile_number;
+    {
+        // Background and window are blank when disabled
+        memset(this->line_colors, 0, this->SCREEN_WIDTH);
+    }
 
-    //if ( (unsigned int)this->VRAM_TILE_DATA_TABLES[mode]) != 0x8800) {
-//    if (tile_number)
-//        std::cout << std::hex << (unsigned int)this->VRAM_TILE_DATA_TABLES[mode] << std::endl;
-    return (uint16_t)(((uint16_t)offset * 16) + this->VRAM_TILE_DATA_TABLES[mode]);
+    // Map colours through palette into the framebuffer, drawing sprites over the top
+    uint32_t *line = this->framebuffer + (ly * this->SCREEN_WIDTH);
+    uint32_t *bg_palette = this->palette_colors[PALETTE_BG];
+    for (unsigned int x = 0; x < this->SCREEN_WIDTH; x ++)
+        line[x] = bg_palette[this->line_colors[x]];
+
+    if (this->line_sprite_count)
+    {
+        for (unsigned int x = 0; x < this->SCREEN_WIDTH; x ++)
+            this->get_sprite_pixel_color(x, this->line_colors[x], line[x]);
+    }
 }
 
-uint16_t VPU::get_current_map_address() {
-    return (uint16_t)((unsigned int)this->VRAM_BG_MAPS[this->get_background_map()] +
-                      (unsigned int)this->get_tile_map_index_from_current_coord());
+// Return the line currently being drawn
+uint8_t VPU::get_ly() {
+    return (uint8_t)this->current_ly;
 }
 
-uint16_t VPU::get_current_tile_data_address() {
-    return this->get_tile_data_address(
-        this->ram->get_val(this->get_current_map_address()));
+uint16_t VPU::get_tile_data_address(uint8_t tile_number) {
+    unsigned int mode = (unsigned int)this->get_background_data_type();
+    // Mode 1 uses unsigned tile numbers from 0x8000.
+    // Mode 0 uses signed tile numbers, with tile 0 at 0x9000,
+    // which is equivalent to flipping the sign bit from 0x8800.
+    uint8_t offset = mode ? tile_number : (uint8_t)(tile_number ^ 0x80);
+    return (uint16_t)(((uint16_t)offset * this->TILE_DATA_SIZE) + this->VRAM_TILE_DATA_TABLES[mode]);
 }
@@ -7,9 +7,18 @@
 
 #include <memory>
 #include "ram.h"
+#include "io_handler.h"
+#include "frame_skip.h"
+#include "runtime_stats.h"
 //#include <SFML/Graphics.hpp>
 #include <stdlib.h>
-#include <SDL.h>
+#include "frame_buffer.h"
+#include "triple_buffer.h"
+#include "screenshot_writer.h"
+#include "video_recorder.h"
+#include "frame_hasher.h"
+#include "scheduler.h"
+#include "interrupt_controller.h"
 
 
 struct vec_2d {
@@ -17,28 +26,90 @@ struct vec_2d {
     unsigned int y;
 };
 
+// Width of background/window maps, in pixels
+#define MAP_PIXEL_WIDTH 256
+
+// Palettes, indexing palette colour lookup
+#define PALETTE_BG 0
+#define PALETTE_OBP0 1
+#define PALETTE_OBP1 2
+#define PALETTE_COUNT 3
+
+// Host colours (ARGB) for each of the 4 shades, from lightest to darkest
+const uint32_t COLOR_SCHEME_GREY[4] = {0xffffffff, 0xffaaaaaa, 0xff555555, 0xff000000};
+const uint32_t COLOR_SCHEME_GREEN[4] = {0xff9bbc0f, 0xff8bac0f, 0xff306230, 0xff0f380f};
+
+// Maximum number of sprites that can be drawn on a single line
+#define MAX_SPRITES_PER_LINE 10
+
+// Sprite entry copied from OAM during the OAM scan (mode 2)
+struct oam_sprite {
+    uint8_t y;
+    uint8_t x;
+    uint8_t tile;
+    uint8_t attributes;
+};
+
+// Saved mode state machine and the frame being drawn, so that
+// frames after loading are identical to those of the original run
+struct vpu_state_t {
+    uint8_t current_mode;
+    uint8_t current_ly;
+    bool lcd_on;
+    bool render_frame;
+    unsigned int window_line;
+    uint64_t next_event_cycle;
+    uint64_t frame_count;
+    oam_sprite line_sprites[MAX_SPRITES_PER_LINE];
+    unsigned int line_sprite_count;
+    frame_buffer_t frame;
+};
+
 enum VpuEventType {
     NONE,
-    EXIT
+    // Frame has completed and V-blank has started
+    VBLANK
 };
 
-class VPU {
+class VPU : public IoHandler {
 public:
-    VPU(RAM *ram);
-    VpuEventType tick();
-    void tear_down();
-    VpuEventType process_events();
-    void capture_screenshot(char* file_path);
-
-    SDL_Window *window;
-    SDL_Renderer *renderer;
-    SDL_Event event;
+    VPU(RAM *ram, RuntimeStats *stats, Scheduler *scheduler, InterruptController *interrupts);
+    // Perform mode transition, when the scheduled VPU event is due
+    VpuEventType process_event();
+    // Capture the last completed frame
+    void capture_screenshot(const char* file_path);
+
+    // LY/STAT register reads and LCD control writes
+    uint8_t io_read(uint16_t address, uint8_t stored_val);
+    void io_write(uint16_t address, uint8_t val);
+
+    // Completed frames, for presentation on another thread
+    TripleBuffer<frame_buffer_t>* get_frame_buffers();
+
+    // Set host colours used for shades
+    void set_color_scheme(const uint32_t colors[4]);
+
+    // Selects which frames are drawn
+    FrameSkip frame_skip;
+    // Writes captured screenshots
+    ScreenshotWriter screenshots;
+    // Record each drawn frame, if set
+    void set_video_recorder(VideoRecorder *video_recorder);
+    // Hash each drawn frame, if set
+    void set_frame_hasher(FrameHasher *frame_hasher);
+    // Number of frames completed since start-up
+    uint64_t get_frame_count();
+
+    void save_state(vpu_state_t &state);
+    // Palette registers must already be restored to RAM
+    void load_state(const vpu_state_t &state);
 private:
+    // Values match STAT mode flag
     enum MODE {
-        MODE0,
-        MODE1,
-        MODE2,
-        MODE3
+        MODE0 = 0,
+        MODE1 = 1,
+        MODE2 = 2,
+        MODE3 = 3
     };
 
     // Clock cycle definitions
@@ -50,22 +121,26 @@ private:
     const unsigned int SCREEN_WIDTH = 160; // 0xA0
     const unsigned int SCREEN_HEIGHT = 144; // 90
     const unsigned int MAX_LY = 0x99;  // 
-    const unsigned int MAX_LX = 0xff;
 
     // Line timings
     // Mode 0 is just the remaining time after mode 2 and 3 and before H_LENGTH
-    const unsigned int MODE0_LENGTH = 0xC9; // 201
-    const unsigned int MODE2_LENGTH = 0x4D; // 77
-    const unsigned int MODE3_LENGTH = 0xA9; // 169
+    const unsigned int MODE0_LENGTH = 0xCC; // 204
+    const unsigned int MODE2_LENGTH = 0x50; // 80
+    const unsigned int MODE3_LENGTH = 0xAC; // 172
     const unsigned int H_LENGTH = 0x01c8; // 456
-    
-    const unsigned int TICKS_PER_PX = 0x04;  // 4 ticks per pixel
 
-    // Current timing for each mode
-    unsigned int mode_timer_itx;
+    // Mode state machine - the VPU only performs work when
+    // the scheduler reaches the next mode transition
     MODE current_mode;
+    unsigned int current_ly;
+    bool lcd_on;
+    uint64_t next_event_cycle;
+    void start_line();
+    VpuEventType start_vblank();
+    void check_lyc_interrupt();
 
-    unsigned int current_lx;
+    // Whether the current frame is being drawn, or just emulated
+    bool render_frame;
 
     // Each is 3FF bytes (1024 bytes), providing 32x32 tiles, meanig 1 byte per tile
     const uint16_t VRAM_BG_MAPS[2] = {(uint16_t)0x9800, (uint16_t)0x9c00};
@@ -75,35 +150,84 @@ private:
     const unsigned int TILE_WIDTH = 8;
     const unsigned int TILE_HEIGHT = 8;
     const unsigned int TILE_DATA_SIZE = 16;
+    // Window X position is offset by 7 pixels
+    const unsigned int WINDOW_X_OFFSET = 7;
+
+    // Object attribute memory - 40 sprites of 4 bytes each
+    const uint16_t OAM_ADDR = (uint16_t)0xfe00;
+    const unsigned int OAM_SPRITE_COUNT = 40;
+    const unsigned int OAM_SPRITE_SIZE = 4;
+    // Sprite positions are offset, so that sprites can be partially off-screen
+    const unsigned int SPRITE_X_OFFSET = 8;
+    const unsigned int SPRITE_Y_OFFSET = 16;
+    // Sprite attribute flags
+    const uint8_t SPRITE_ATTR_PRIORITY = 0x80;
+    const uint8_t SPRITE_ATTR_Y_FLIP = 0x40;
+    const uint8_t SPRITE_ATTR_X_FLIP = 0x20;
+    const uint8_t SPRITE_ATTR_PALETTE = 0x10;
+    // Sprite tile data is always read from 0x8000, using unsigned tile numbers
+    const uint16_t SPRITE_TILE_DATA_ADDR = (uint16_t)0x8000;
 
-    void increment_lx_ly();
-    
     void trigger_stat_interrupt();
 
     RAM *ram;
+    RuntimeStats *stats;
+    Scheduler *scheduler;
+    InterruptController *interrupts;
 
     uint8_t get_background_scroll_x();
     uint8_t get_background_scroll_y();
-    uint8_t get_lx();
     uint8_t get_ly();
 
     // Control register bits
-    void update_mode_flag();
     uint8_t get_background_map();
     uint8_t get_background_data_type();
-    uint8_t lcd_enabled();
+    uint8_t background_enabled();
+    uint8_t window_enabled();
+    uint8_t get_window_map();
+    uint8_t sprites_enabled();
+    uint8_t get_sprite_height();
 
-    unsigned int get_tile_map_index_from_current_coord();
     uint16_t get_tile_data_address(uint8_t tile_number);
-    uint8_t get_pixel_color();
-    uint16_t get_tile_address();
-    uint16_t get_current_tile_data_address();
-    uint16_t get_current_map_address();
-    vec_2d get_pixel_tile_position();
-
-    uint8_t current_draw_pixel;
-    void process_pixel();
-    void wait_for_window();
-    void redraw();
+
+    // Internal line counter for the window, which only increments
+    // on lines that the window has been drawn
+    unsigned int window_line;
+    // Single decoded line of a tile map
+    uint8_t map_row[MAP_PIXEL_WIDTH];
+    void decode_map_row(uint8_t map, uint8_t y);
+    // Background/window colour indexes for the line being drawn
+    uint8_t line_colors[SCREEN_PIXEL_WIDTH];
+    void render_line();
+
+    // Sprites visible on the current line, ordered by draw priority.
+    // Populated once per line during the OAM scan.
+    oam_sprite line_sprites[MAX_SPRITES_PER_LINE];
+    unsigned int line_sprite_count;
+    void scan_oam();
+    bool get_sprite_pixel_color(unsigned int x, uint8_t background_color, uint32_t &sprite_color);
+    uint8_t get_tile_pixel(uint16_t tile_line_address, unsigned int x);
+
+
+    // Host colour for each shade and resulting host colour for each
+    // colour index of each palette, which is rebuilt when a palette
+    // register is written
+    uint32_t color_scheme[4];
+    uint32_t palette_colors[PALETTE_COUNT][4];
+    void update_palette(unsigned int palette, uint8_t palette_data);
+
+    // Frames are drawn directly into the write buffer of the triple buffer,
+    // which is published at V-blank
+    TripleBuffer<frame_buffer_t> frame_buffers;
+    uint32_t *framebuffer;
+    // Most recently completed frame, which is not modified
+    // until the next frame is published
+    const frame_buffer_t *last_frame;
+    void publish_frame();
+
+    VideoRecorder *video_recorder;
+    FrameHasher *frame_hasher;
+    // Number of frames completed since start-up, including skipped frames
+    uint64_t frame_count;
 
 };
@@ -0,0 +1,69 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+#include "work_stealing_pool.h"
+
+#include <thread>
+
+WorkStealingPool::WorkStealingPool(unsigned int thread_count)
+{
+    this->thread_count = thread_count > 0 ? thread_count : 1;
+    for (unsigned int itx = 0; itx < this->thread_count; itx ++)
+        this->queues.push_back(std::unique_ptr<worker_queue_t>(new worker_queue_t()));
+    this->next_queue = 0;
+}
+
+void WorkStealingPool::add(std::function<void()> job)
+{
+    this->queues[this->next_queue]->jobs.push_back(job);
+    this->next_queue = (this->next_queue + 1) % this->thread_count;
+}
+
+void WorkStealingPool::run()
+{
+    // Calling thread runs the first worker
+    std::vector<std::thread> threads;
+    for (unsigned int worker = 1; worker < this->thread_count; worker ++)
+        threads.push_back(std::thread(&WorkStealingPool::run_worker, this, worker));
+    this->run_worker(0);
+    for (unsigned int itx = 0; itx < threads.size(); itx ++)
+        threads[itx].join();
+}
+
+void WorkStealingPool::run_worker(unsigned int worker)
+{
+    std::function<void()> job;
+    while (this->take_job(worker, job))
+        job();
+}
+
+bool WorkStealingPool::take_job(unsigned int worker, std::function<void()> &job)
+{
+    {
+        worker_queue_t *own = this->queues[worker].get();
+        std::lock_guard<std::mutex> lock(own->mutex);
+        if (! own->jobs.empty())
+        {
+            job = own->jobs.back();
+            own->jobs.pop_back();
+            return true;
+        }
+    }
+
+    // No jobs are added whilst running, so once every queue
+    // is empty, there is no more work
+    for (unsigned int offset = 1; offset < this->thread_count; offset ++)
+    {
+        worker_queue_t *victim = this->queues[(worker + offset) % this->thread_count].get();
+        std::lock_guard<std::mutex> lock(victim->mutex);
+        if (! victim->jobs.empty())
+        {
+            job = victim->jobs.front();
+            victim->jobs.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
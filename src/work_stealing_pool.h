@@ -0,0 +1,40 @@
+// Copyright (C) Dock Studios Ltd, Inc - All Rights Reserved
+// Unauthorized copying of this file, via any medium is strictly prohibited
+// Proprietary and confidential
+// Written by Matt Comben <matthew@dockstudios.co.uk>, May 2019
+
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <functional>
+
+// Runs a set of jobs across a fixed number of threads. Jobs are
+// dealt out to a queue per thread; each thread takes jobs from the
+// back of its own queue and, once that is empty, steals from the
+// front of the others, so threads with short jobs take over the
+// work of those with long ones.
+class WorkStealingPool {
+public:
+    WorkStealingPool(unsigned int thread_count);
+
+    // Add job, before run
+    void add(std::function<void()> job);
+    // Run all jobs, returning once they have completed
+    void run();
+
+private:
+    struct worker_queue_t {
+        std::mutex mutex;
+        std::deque<std::function<void()> > jobs;
+    };
+
+    unsigned int thread_count;
+    std::vector<std::unique_ptr<worker_queue_t> > queues;
+    unsigned int next_queue;
+
+    void run_worker(unsigned int worker);
+    bool take_job(unsigned int worker, std::function<void()> &job);
+};
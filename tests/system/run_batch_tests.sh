@@ -0,0 +1,9 @@
+#!/bin/bash
+
+# Run all system test ROMs in a single process, in parallel,
+# checking both serial results and final screen hashes
+
+bios=${BIOS:-./copyright/DMG_ROM.bin}
+
+./GameboyEmulator --batch ./tests/system/batch_manifest.txt -b "$bios" -j "${JOBS:-$(nproc)}" | grep -E "^(PASS|FAIL|ERROR|Batch:) "
+exit ${PIPESTATUS[0]}
@@ -0,0 +1,25 @@
+#!/bin/bash
+
+# Run system test ROMs headless, in-process, passing as soon as
+# the expected final screen hash is seen
+
+set -e
+
+bios=${BIOS:-./copyright/DMG_ROM.bin}
+failed=0
+
+while read rom expected
+do
+    # Skip comments
+    [[ "$rom" == \#* || -z "$rom" ]] && continue
+
+    if ./GameboyEmulator -H -f "./tests/system/roms/$rom" -b "$bios" -X "$expected" > /dev/null
+    then
+        echo "PASS: $rom"
+    else
+        echo "FAIL: $rom"
+        failed=1
+    fi
+done < ./tests/system/expected_hashes.txt
+
+exit $failed
@@ -0,0 +1,50 @@
+#!/bin/bash
+
+# Record a movie of each test ROM, with scripted input and audio
+# output, then check that it replays exactly, and that a replay with
+# altered input fails at the frame it was altered
+
+bios=${BIOS:-./copyright/DMG_ROM.bin}
+record_ticks=10000000
+movie_dir=$(mktemp -d)
+trap "rm -rf $movie_dir" EXIT
+failed=0
+
+printf "40 start down\n45 start up\n60 a down\n90 a up\n" > $movie_dir/input.txt
+
+for rom in 01-special 02-interrupts 04-op_r,imm 05-op_rp 06-ld_r,r 07-jr,jp,call,ret,rst 08-misc-instrs 09-op_r,r 10-bit_ops 11-op_a,-hl
+do
+    movie=$movie_dir/$rom.gbm
+    if ! ./GameboyEmulator -H -f "./tests/system/roms/$rom.gb" -b "$bios" -t $record_ticks -i $movie_dir/input.txt \
+            -a $movie_dir/audio.wav --record-movie $movie --movie-checkpoints 1 > /dev/null
+    then
+        echo "FAIL: $rom: unable to record"
+        failed=1
+        continue
+    fi
+
+    if ! ./GameboyEmulator -f "./tests/system/roms/$rom.gb" -b "$bios" --replay-movie $movie > /dev/null
+    then
+        echo "FAIL: $rom: replay diverged"
+        failed=1
+        continue
+    fi
+
+    # Also press B with the first input, which follows the 56 byte header
+    # and initial state, as a 4 byte frame number then the buttons pressed
+    state_size=$(od -A n -t u4 -j 16 -N 4 $movie | tr -d ' ')
+    offset=$((56 + state_size))
+    frame=$(( $(od -A n -t u4 -j $offset -N 4 $movie) + 1 ))
+    offset=$((offset + 4))
+    printf "\\x$(printf %02x $(( $(od -A n -t u1 -j $offset -N 1 $movie) ^ 0x20 )))" | \
+        dd of=$movie bs=1 seek=$offset conv=notrunc status=none
+    if ! ./GameboyEmulator -f "./tests/system/roms/$rom.gb" -b "$bios" --replay-movie $movie | grep -q "diverged at frame $frame:"
+    then
+        echo "FAIL: $rom: altered replay did not diverge at frame $frame"
+        failed=1
+        continue
+    fi
+    echo "PASS: $rom"
+done
+
+exit $failed
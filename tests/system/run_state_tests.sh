@@ -0,0 +1,48 @@
+#!/bin/bash
+
+# Save the state of each batch test ROM part way through, then check
+# that resuming from it gives the same result (including a hash of
+# memory) as running from power-on
+
+bios=${BIOS:-./copyright/DMG_ROM.bin}
+# Save states after this many CPU ticks, before any ROM completes
+save_ticks=1500000
+state_dir=$(mktemp -d)
+trap "rm -rf $state_dir" EXIT
+
+cold_manifest=$state_dir/cold.txt
+warm_manifest=$state_dir/warm.txt
+itx=0
+grep -v "^#" ./tests/system/batch_manifest.txt | while read rom options
+do
+    state="$state_dir/$itx.state"
+    if ! ./GameboyEmulator -H -f "$rom" -b "$bios" -t $save_ticks --save-state "$state" > /dev/null
+    then
+        echo "ERROR: unable to save state for $rom"
+    fi
+    echo "$rom $options" >> $cold_manifest
+    echo "$rom $options state=$state" >> $warm_manifest
+    itx=$((itx + 1))
+done
+
+# Compare results, without host time
+run_batch() {
+    ./GameboyEmulator --batch $1 -b "$bios" | grep -E "^(PASS|FAIL|ERROR) " | sed 's/, [0-9.]*ms)$/)/'
+}
+
+cold=$(run_batch $cold_manifest)
+warm=$(run_batch $warm_manifest)
+
+if [ "$cold" != "$warm" ]
+then
+    echo "FAIL: results from save states differ from power-on"
+    diff <(echo "$cold") <(echo "$warm")
+    exit 1
+fi
+if echo "$warm" | grep -qv "^PASS "
+then
+    echo "FAIL: not all ROMs passed"
+    echo "$warm"
+    exit 1
+fi
+echo "PASS: $(echo "$warm" | wc -l) ROMs matched when resumed from save states"
@@ -0,0 +1,36 @@
+#!/bin/bash
+
+# Run 64 emulator instances at once, on 64 threads, checking that each
+# result (including a hash of memory) matches running them one at a time
+
+bios=${BIOS:-./copyright/DMG_ROM.bin}
+instances=64
+manifest=$(mktemp)
+trap "rm -f $manifest" EXIT
+
+roms=(01-special 02-interrupts 04-op_r,imm 05-op_rp 06-ld_r,r 07-jr,jp,call,ret,rst 08-misc-instrs 09-op_r,r 10-bit_ops 11-op_a,-hl)
+for ((itx = 0; itx < instances; itx ++))
+do
+    echo "./tests/system/roms/${roms[$((itx % ${#roms[@]}))]}.gb ticks=20000000 pass=Passed fail=Failed" >> $manifest
+done
+
+# Compare results, without host time
+run_batch() {
+    ./GameboyEmulator --batch $manifest -b "$bios" -j $1 | grep -E "^(PASS|FAIL|ERROR) " | sed 's/, [0-9.]*ms)$/)/'
+}
+
+serial=$(run_batch 1)
+parallel=$(run_batch $instances)
+
+if [ "$(echo "$serial" | wc -l)" != "$instances" ]
+then
+    echo "FAIL: expected $instances results"
+    exit 1
+fi
+if [ "$serial" != "$parallel" ]
+then
+    echo "FAIL: parallel results differ from serial results"
+    diff <(echo "$serial") <(echo "$parallel")
+    exit 1
+fi
+echo "PASS: $instances parallel instances matched serial runs"